@@ -0,0 +1,138 @@
+#pragma once
+
+// Fixed-width binary export layout for --format bin, plus a reference reader.
+//
+// File layout (little-endian, every section 4-byte aligned):
+//   BinHeader | recordCount * recordSize bytes of records | string table
+//
+// Display records reference UTF-8 names in the string table by offset/length;
+// each string is also NUL-terminated. Mode tables have an empty string table.
+// Later versions may only append fields to records (and grow the header up to
+// recordsOffset); readers accept any version >= 1 and step by header.recordSize.
+// This header is Win32-free so the format can be consumed on any platform.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace drt {
+
+constexpr char kBinMagic[4] = {'D', 'M', 'B', 'F'};
+constexpr uint16_t kBinVersion = 2;       // 2: BinModeRecord.flags
+
+enum BinKind : uint16_t {
+    BinKindDisplays = 1,
+    BinKindModes = 2,
+};
+
+enum BinDisplayFlags : uint32_t {
+    BinDisplayPrimary = 1u << 0,
+};
+
+enum BinModeFlags : uint32_t {
+    BinModeNative = 1u << 0,  // monitor's preferred/native timing (EDID)
+};
+
+struct BinHeader {
+    char magic[4];           // kBinMagic
+    uint16_t version;        // kBinVersion when written; readers accept >= 1
+    uint16_t kind;           // BinKind
+    uint32_t recordCount;
+    uint32_t recordSize;     // sizeof the record type at `version`
+    uint32_t recordsOffset;  // from start of file
+    uint32_t stringsOffset;  // from start of file
+    uint32_t stringsSize;
+    uint32_t reserved;
+};
+
+struct BinDisplayRecord {
+    uint32_t adapterLuidLow;
+    int32_t adapterLuidHigh;
+    uint32_t targetId;
+    uint32_t flags;          // BinDisplayFlags
+    uint32_t nameOffset;     // friendly name, into the string table
+    uint32_t nameLength;
+    uint32_t sourceOffset;   // GDI source name, into the string table
+    uint32_t sourceLength;
+};
+
+struct BinModeRecord {
+    int32_t width;
+    int32_t height;
+    int32_t hz;
+    int32_t orientation;     // DMDO_*
+    int32_t bitsPerPel;
+    uint32_t flags;          // BinModeFlags; version >= 2
+};
+
+// Size of a version 1 mode record, the smallest a reader accepts.
+constexpr size_t kBinModeRecordV1Size = offsetof(BinModeRecord, flags);
+
+static_assert(sizeof(BinHeader) == 32, "BinHeader layout changed");
+static_assert(sizeof(BinDisplayRecord) == 32, "BinDisplayRecord layout changed");
+static_assert(sizeof(BinModeRecord) == 24, "BinModeRecord layout changed");
+
+// Zero-copy view over a validated export buffer (e.g. a memory-mapped file).
+struct BinTableView {
+    const BinHeader* header = nullptr;
+    const unsigned char* records = nullptr;
+    const char* strings = nullptr;
+};
+
+// Validate `data` as an export of kind `kind` and point `view` into it. The buffer
+// must be 4-byte aligned and outlive the view.
+inline bool openBinTable(const void* data, size_t size, uint16_t kind, BinTableView& view, std::string& errorMessage) {
+    view = {};
+    const auto* base = static_cast<const unsigned char*>(data);
+    if (!base || size < sizeof(BinHeader)) { errorMessage = "Truncated header"; return false; }
+    if (reinterpret_cast<uintptr_t>(base) % alignof(BinHeader) != 0) { errorMessage = "Misaligned buffer"; return false; }
+
+    const auto* h = reinterpret_cast<const BinHeader*>(base);
+    if (std::memcmp(h->magic, kBinMagic, sizeof(kBinMagic)) != 0) { errorMessage = "Bad magic"; return false; }
+    if (h->version < 1) { errorMessage = "Unsupported version " + std::to_string(h->version); return false; }
+    if (h->kind != kind) { errorMessage = "Unexpected table kind"; return false; }
+
+    size_t minRecord = (kind == BinKindDisplays) ? sizeof(BinDisplayRecord) : kBinModeRecordV1Size;
+    if (h->recordSize < minRecord || h->recordSize % 4 != 0) { errorMessage = "Bad record size"; return false; }
+    if (h->recordsOffset % 4 != 0 || h->recordsOffset < sizeof(BinHeader)) { errorMessage = "Bad records offset"; return false; }
+
+    uint64_t recordsEnd = uint64_t(h->recordsOffset) + uint64_t(h->recordCount) * h->recordSize;
+    uint64_t stringsEnd = uint64_t(h->stringsOffset) + h->stringsSize;
+    if (recordsEnd > size || stringsEnd > size || h->stringsOffset < recordsEnd) {
+        errorMessage = "Section out of bounds";
+        return false;
+    }
+
+    view.header = h;
+    view.records = base + h->recordsOffset;
+    view.strings = reinterpret_cast<const char*>(base + h->stringsOffset);
+    return true;
+}
+
+inline const BinDisplayRecord* binDisplayAt(const BinTableView& view, uint32_t i) {
+    if (!view.header || i >= view.header->recordCount) return nullptr;
+    return reinterpret_cast<const BinDisplayRecord*>(view.records + size_t(i) * view.header->recordSize);
+}
+
+// Only the version 1 fields are guaranteed present; read flags via binModeFlags.
+inline const BinModeRecord* binModeAt(const BinTableView& view, uint32_t i) {
+    if (!view.header || i >= view.header->recordCount) return nullptr;
+    return reinterpret_cast<const BinModeRecord*>(view.records + size_t(i) * view.header->recordSize);
+}
+
+// BinModeFlags of mode record `i`; 0 for version 1 tables, which have no flags field.
+inline uint32_t binModeFlags(const BinTableView& view, uint32_t i) {
+    const BinModeRecord* r = binModeAt(view, i);
+    if (!r || view.header->recordSize < sizeof(BinModeRecord)) return 0;
+    return r->flags;
+}
+
+// String table lookup; returns an empty view if the reference is out of bounds.
+inline std::string_view binString(const BinTableView& view, uint32_t offset, uint32_t length) {
+    if (!view.header || uint64_t(offset) + length > view.header->stringsSize) return {};
+    return std::string_view(view.strings + offset, length);
+}
+
+} // namespace drt
@@ -57,6 +57,46 @@ bool drt::parseArgs(int argc, char **argv, drt::Args &out)
             out.listModes = true;
             continue;
         }
+        if (parseBoolFlag(a, "--common-modes"))
+        {
+            out.commonModes = true;
+            continue;
+        }
+        if (parseBoolFlag(a, "--all"))
+        {
+            out.all = true;
+            continue;
+        }
+        if (parseBoolFlag(a, "--apply-best"))
+        {
+            out.applyBest = true;
+            continue;
+        }
+        if (parseBoolFlag(a, "--confirm"))
+        {
+            out.confirm = true;
+            int seq = 0;
+            if (i + 1 < argc && parseInt(argv[i + 1], seq))
+            {
+                if (seq <= 0) return false;
+                out.confirmSeq = seq;
+                ++i;
+            }
+            continue;
+        }
+        if (parseBoolFlag(a, "--revert"))
+        {
+            // Optional count; defaults to the last change.
+            out.revert = 1;
+            int n = 0;
+            if (i + 1 < argc && parseInt(argv[i + 1], n))
+            {
+                if (n <= 0) return false;
+                out.revert = n;
+                ++i;
+            }
+            continue;
+        }
         if (parseBoolFlag(a, "--persist"))
         {
             out.persist = true;
@@ -88,6 +128,23 @@ bool drt::parseArgs(int argc, char **argv, drt::Args &out)
             out.display = argv[++i];
             continue;
         }
+        if (std::strcmp(a, "--format") == 0 && i + 1 < argc)
+        {
+            std::string_view f = argv[++i];
+            if (f != "text" && f != "json" && f != "csv" && f != "ndjson" && f != "bin")
+                return false;
+            out.format = f;
+            if (f == "json") out.json = true;
+            continue;
+        }
+        if (std::strcmp(a, "--source") == 0 && i + 1 < argc)
+        {
+            std::string_view src = argv[++i];
+            if (src != "edid" && src != "driver" && src != "both")
+                return false;
+            out.source = src;
+            continue;
+        }
         if (std::strcmp(a, "--width") == 0 && i + 1 < argc)
         {
             if (!parseInt(argv[++i], out.width)) return false;
@@ -103,6 +160,11 @@ bool drt::parseArgs(int argc, char **argv, drt::Args &out)
             if (!parseInt(argv[++i], out.hz)) return false;
             continue;
         }
+        if (std::strcmp(a, "--confirm-within") == 0 && i + 1 < argc)
+        {
+            if (!parseInt(argv[++i], out.confirmWithin) || out.confirmWithin <= 0) return false;
+            continue;
+        }
         if (std::strcmp(a, "--orientation") == 0 && i + 1 < argc)
         {
             int o = parseOrientationToken(argv[++i]);
@@ -124,18 +186,28 @@ std::string drt::usage(const std::string &program)
     std::ostringstream ss;
     ss << "Usage:\n"
        << "  " << program << " --list [--json]\n"
-       << "  " << program << " --list-modes --display <index|name|\\\\.\\DISPLAYn> [--json]\n"
-       << "  " << program << " --display <index|name|\\\\.\\DISPLAYn> [--width W --height H] [--hz F] [--orientation (0|90|180|270)] [--persist] [--dry-run] [--json]\n\n"
+       << "  " << program << " --list-modes --display <index|name|\\\\.\\DISPLAYn> [--source edid|driver|both] [--json]\n"
+       << "  " << program << " --common-modes (--display <sel>,<sel>,... | --all) [--apply-best [--persist] [--dry-run] [--confirm-within S]] [--json]\n"
+       << "  " << program << " --display <index|name|\\\\.\\DISPLAYn> [--width W --height H] [--hz F] [--orientation (0|90|180|270)] [--persist] [--dry-run] [--confirm-within S] [--json]\n"
+       << "  " << program << " --revert [N] | --confirm [SEQ]\n\n"
        << "Options:\n"
        << "  --list                     List active displays.\n"
        << "  --list-modes               List modes for a display (requires --display).\n"
+       << "  --common-modes             List modes supported by every selected display, best first.\n"
        << "  --display <sel>            Select display by index (from --list), friendly name substring, or source (e.g., \\\\.\\DISPLAY1).\n"
+       << "  --all                      Select all active displays (with --common-modes).\n"
+       << "  --apply-best               Apply the best common mode to all selected displays; all or none.\n"
+       << "  --source <src>             Mode source for --list-modes/--common-modes: driver (default), edid, or both.\n"
        << "  --width/--height           Target resolution. If only one set, the other must be provided.\n"
        << "  --hz                       Target refresh rate.\n"
        << "  --orientation              0=landscape,90=portrait,180=landscape-flipped,270=portrait-flipped.\n"
        << "  --persist                  Save change to registry (CDS_UPDATEREGISTRY).\n"
        << "  --dry-run                  Validate only (no change).\n"
+       << "  --confirm-within <s>       Roll back unless confirmed (Enter or --confirm) within s seconds.\n"
+       << "  --confirm [SEQ]            Confirm change SEQ, or the newest change still awaiting confirmation.\n"
+       << "  --revert [N]               Undo the last N changes (default 1) from the undo journal.\n"
        << "  --json                     Machine-readable output.\n"
+       << "  --format <fmt>             text|json|csv|ndjson|bin for --list, --list-modes and --common-modes.\n"
        << "  --verbose                  Extra diagnostics to stderr.\n"
        << "  --quiet                    Suppress human-readable output.\n";
     return ss.str();
@@ -10,9 +10,15 @@ namespace drt
         // operations
         bool list = false;           // --list
         bool listModes = false;      // --list-modes
+        bool commonModes = false;    // --common-modes
+        int revert = 0;              // --revert [N] (0 = not requested)
+        bool confirm = false;        // --confirm [SEQ]
+        int confirmSeq = 0;          // change to confirm (0 = newest awaiting confirmation)
 
         // target selection
-        std::string display;         // --display <id|index|name>
+        std::string display;         // --display <id|index|name>[,...]
+        bool all = false;            // --all
+        std::string source;          // --source edid|driver|both (mode listing)
 
         // requested mode parameters
         int width = -1;              // --width
@@ -23,7 +29,10 @@ namespace drt
         // behavior flags
         bool persist = false;        // --persist
         bool dryRun = false;         // --dry-run
-        bool json = false;           // --json
+        bool applyBest = false;      // --apply-best
+        int confirmWithin = -1;      // --confirm-within <seconds>
+        bool json = false;           // --json (or --format json)
+        std::string format;          // --format text|json|csv|ndjson|bin
         bool verbose = false;        // --verbose
         bool quiet = false;          // --quiet
     };
@@ -1,4 +1,6 @@
 #include "display_config.h"
+#include "edid.h"
+#include "journal.h"
 #include "util.h"
 
 #include <vector>
@@ -7,55 +9,32 @@
 #include <sstream>
 #include <algorithm>
 
-static bool getTargetFriendlyName(const DISPLAYCONFIG_PATH_INFO& path, std::string& out) {
-    DISPLAYCONFIG_TARGET_DEVICE_NAME name = {};
-    name.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_NAME;
-    name.header.size = sizeof(name);
-    name.header.adapterId = path.targetInfo.adapterId;
-    name.header.id = path.targetInfo.id;
-    if (DisplayConfigGetDeviceInfo(&name.header) != ERROR_SUCCESS) return false;
+namespace {
 
-    out = drt::to_utf8(name.monitorFriendlyDeviceName);
-    return !out.empty();
-}
+class Win32DisplayConfigBackend : public drt::DisplayConfigBackend {
+public:
+    LONG getBufferSizes(UINT32 flags, UINT32* numPaths, UINT32* numModes) override {
+        return GetDisplayConfigBufferSizes(flags, numPaths, numModes);
+    }
+    LONG queryConfig(UINT32 flags, UINT32* numPaths, DISPLAYCONFIG_PATH_INFO* paths,
+                     UINT32* numModes, DISPLAYCONFIG_MODE_INFO* modes) override {
+        return QueryDisplayConfig(flags, numPaths, paths, numModes, modes, nullptr);
+    }
+    LONG getDeviceInfo(DISPLAYCONFIG_DEVICE_INFO_HEADER* header) override {
+        return DisplayConfigGetDeviceInfo(header);
+    }
+};
 
-static bool getSourceDeviceName(const DISPLAYCONFIG_PATH_INFO& path, std::string& out) {
-    DISPLAYCONFIG_SOURCE_DEVICE_NAME src = {};
-    src.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
-    src.header.size = sizeof(src);
-    src.header.adapterId = path.sourceInfo.adapterId;
-    src.header.id = path.sourceInfo.id;
-    if (DisplayConfigGetDeviceInfo(&src.header) != ERROR_SUCCESS) return false;
-    out = drt::to_utf8(src.viewGdiDeviceName);
-    return !out.empty();
+} // namespace
+
+drt::DisplayConfigBackend& drt::win32DisplayConfigBackend() {
+    static Win32DisplayConfigBackend backend;
+    return backend;
 }
 
 bool drt::listDisplays(std::vector<drt::DisplayInfo>& out, std::string& errorMessage) {
-    UINT32 pathCount = 0, modeCount = 0;
-    LONG st = GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount);
-    if (st != ERROR_SUCCESS) { errorMessage = "GetDisplayConfigBufferSizes failed"; return false; }
-    std::vector<DISPLAYCONFIG_PATH_INFO> paths(pathCount);
-    std::vector<DISPLAYCONFIG_MODE_INFO> modes(modeCount);
-    st = QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, paths.data(), &modeCount, modes.data(), nullptr);
-    if (st != ERROR_SUCCESS) { errorMessage = "QueryDisplayConfig failed"; return false; }
-
-    out.clear();
-    out.reserve(pathCount);
-    for (UINT32 i = 0; i < pathCount; ++i) {
-        const auto& p = paths[i];
-        DisplayInfo info;
-        info.id.adapterLuid = p.targetInfo.adapterId;
-        info.id.targetId = p.targetInfo.id;
-        info.isPrimary = (p.sourceInfo.id == 0);
-        getTargetFriendlyName(p, info.friendlyName);
-        getSourceDeviceName(p, info.sourceName);
-        out.push_back(info);
-    }
-    if (out.empty()) {
-        errorMessage = "No active displays found";
-        return false;
-    }
-    return true;
+    DisplayQueryContext ctx;
+    return listDisplays(ctx, out, errorMessage);
 }
 
 bool drt::listModes(const std::string& sourceName, std::vector<drt::ModeInfo>& out, std::string& errorMessage) {
@@ -77,15 +56,125 @@ bool drt::listModes(const std::string& sourceName, std::vector<drt::ModeInfo>& o
         return false;
     }
     // Sort unique by width, height, hz
-    std::sort(out.begin(), out.end(), [](const ModeInfo& a, const ModeInfo& b){
-        if (a.width != b.width) return a.width < b.width;
-        if (a.height != b.height) return a.height < b.height;
-        if (a.hz != b.hz) return a.hz < b.hz;
-        return a.orientation < b.orientation;
-    });
-    out.erase(std::unique(out.begin(), out.end(), [](const ModeInfo& a, const ModeInfo& b){
-        return a.width==b.width && a.height==b.height && a.hz==b.hz && a.orientation==b.orientation;
-    }), out.end());
+    sortUniqueModes(out);
+    return true;
+}
+
+// Device path of the monitor currently attached to target `id`; empty on failure.
+static std::wstring monitorDevicePath(drt::DisplayConfigBackend& backend, const drt::DisplayId& id) {
+    DISPLAYCONFIG_TARGET_DEVICE_NAME name = {};
+    name.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_NAME;
+    name.header.size = sizeof(name);
+    name.header.adapterId = id.adapterLuid;
+    name.header.id = id.targetId;
+    if (backend.getDeviceInfo(&name.header) != ERROR_SUCCESS) return {};
+    return std::wstring(name.monitorDevicePath, wcsnlen(name.monitorDevicePath, std::size(name.monitorDevicePath)));
+}
+
+// The monitor device path \\?\DISPLAY#<hwid>#<instance>#{guid} names the device key
+// HKLM\SYSTEM\CurrentControlSet\Enum\DISPLAY\<hwid>\<instance>, whose
+// "Device Parameters" subkey holds the raw EDID.
+static bool readEdidFromRegistry(std::wstring path, std::vector<unsigned char>& out) {
+    const std::wstring prefix = L"\\\\?\\";
+    if (path.compare(0, prefix.size(), prefix) == 0) path.erase(0, prefix.size());
+    std::wstring key = L"SYSTEM\\CurrentControlSet\\Enum";
+    size_t start = 0;
+    for (int part = 0; part < 3; ++part) {
+        size_t hash = path.find(L'#', start);
+        if (hash == std::wstring::npos) return false;
+        key += L'\\';
+        key.append(path, start, hash - start);
+        start = hash + 1;
+    }
+    key += L"\\Device Parameters";
+
+    DWORD size = 0;
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, key.c_str(), L"EDID", RRF_RT_REG_BINARY, nullptr, nullptr, &size) != ERROR_SUCCESS
+        || size == 0) {
+        return false;
+    }
+    out.resize(size);
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, key.c_str(), L"EDID", RRF_RT_REG_BINARY, nullptr, out.data(), &size) != ERROR_SUCCESS) {
+        out.clear();
+        return false;
+    }
+    out.resize(size);
+    return true;
+}
+
+// Keyed by the monitor's device path rather than the target, so a different
+// monitor plugged into the same port is read afresh.
+static const drt::DisplayQueryContext::EdidEntry& cachedEdid(drt::DisplayQueryContext& ctx, const drt::DisplayId& id) {
+    std::wstring path = monitorDevicePath(*ctx.backend, id);
+    for (const auto& e : ctx.edid) {
+        if (!path.empty() && e.devicePath == path) return e;
+    }
+    ctx.edid.emplace_back();
+    auto& e = ctx.edid.back();
+    e.devicePath = path;
+    e.found = !path.empty() && readEdidFromRegistry(path, e.blob);
+    return e;
+}
+
+bool drt::listModes(drt::DisplayQueryContext& ctx, drt::DisplayInfo& display, drt::ModeSource source,
+                    std::vector<drt::ModeInfo>& out, std::string& errorMessage) {
+    out.clear();
+    errorMessage.clear();
+    display.edidModes.clear();
+    display.edidMaxHz = 0;
+    if (source != ModeSource::Edid && !listModes(display.sourceName, out, errorMessage)) return false;
+    if (source == ModeSource::Driver) return true;
+
+    const auto& edid = cachedEdid(ctx, display.id);
+    EdidInfo info;
+    if (!edid.found) {
+        errorMessage = "No EDID available for " + display.sourceName;
+    } else if (!parseEdid(edid.blob.data(), edid.blob.size(), info, errorMessage)) {
+        errorMessage = "Unreadable EDID for " + display.sourceName + ": " + errorMessage;
+    }
+    if (!errorMessage.empty()) {
+        if (source == ModeSource::Edid) return false;
+        // Both: the driver list alone is still a valid answer; report the EDID problem as a warning.
+        errorMessage += "; showing driver modes only";
+        return true;
+    }
+    for (const auto& e : info.modes) {
+        ModeInfo m;
+        m.width = e.width;
+        m.height = e.height;
+        m.hz = e.hz;
+        m.orientation = DMDO_DEFAULT;
+        m.native = e.preferred;
+        display.edidModes.push_back(m);
+    }
+    sortUniqueModes(display.edidModes);
+    display.edidMaxHz = info.maxHz;
+
+    if (source == ModeSource::Edid) {
+        out = display.edidModes;
+    } else {
+        // Sorted union; on duplicates keep the driver entry (real bpp) but carry
+        // over the monitor's native flag.
+        const auto& edidModes = display.edidModes;
+        std::vector<ModeInfo> merged;
+        merged.reserve(out.size() + edidModes.size());
+        size_t i = 0, j = 0;
+        while (i < out.size() || j < edidModes.size()) {
+            if (j == edidModes.size() || (i < out.size() && modeLess(out[i], edidModes[j]))) {
+                merged.push_back(out[i++]);
+            } else if (i == out.size() || modeLess(edidModes[j], out[i])) {
+                merged.push_back(edidModes[j++]);
+            } else {
+                merged.push_back(out[i++]);
+                merged.back().native = edidModes[j++].native;
+            }
+        }
+        out.swap(merged);
+    }
+    if (out.empty()) {
+        errorMessage = "No modes advertised in EDID for " + display.sourceName;
+        return false;
+    }
     return true;
 }
 
@@ -138,8 +227,28 @@ bool drt::applyMode(const drt::ApplyRequest& req, drt::ApplyResult& result) {
 
     DWORD flags = req.persist ? CDS_UPDATEREGISTRY : 0;
     if (req.dryRun) flags |= CDS_TEST;
+    // A change that must be confirmed reaches the registry only on confirmation
+    // (journalConfirm), so a crash or reboot before then cannot make it stick.
+    DWORD deferred = 0;
+    if (req.confirmWithin > 0 && !req.dryRun) {
+        deferred = flags & CDS_UPDATEREGISTRY;
+        flags &= ~static_cast<DWORD>(CDS_UPDATEREGISTRY);
+    }
 
+    if (!req.dryRun) {
+        result.journalSeq = journalBegin(req.sourceName, current, flags);
+        // A change that must be confirmed is only safe if it can be rolled back.
+        if (req.confirmWithin > 0
+            && (result.journalSeq == 0 || !journalAwait(result.journalSeq, req.confirmWithin, deferred))) {
+            journalEnd(result.journalSeq, DISP_CHANGE_FAILED); // not applied; keep it out of --revert
+            result.journalSeq = 0;
+            result.message = "Undo journal could not be written; not applying a change that needs confirmation";
+            return false;
+        }
+    }
     LONG ch = ChangeDisplaySettingsExA(req.sourceName.c_str(), &target, nullptr, flags, nullptr);
+    journalEnd(result.journalSeq, ch);
+    result.applied = ch == DISP_CHANGE_SUCCESSFUL && !req.dryRun;
     if (ch != DISP_CHANGE_SUCCESSFUL) {
         result.success = false;
         result.changed = false;
@@ -184,6 +293,7 @@ bool drt::applyMode(const drt::ApplyRequest& req, drt::ApplyResult& result) {
 
     result.success = true;
     result.changed = true;
-    result.message = req.persist ? "Applied and persisted" : "Applied (session only)";
+    result.message = deferred ? "Applied (persisted once confirmed)"
+                   : req.persist ? "Applied and persisted" : "Applied (session only)";
     return true;
 }
@@ -5,6 +5,8 @@
 
 #include <windows.h>
 
+#include "modes.h"
+
 namespace drt {
 
 struct DisplayId {
@@ -17,14 +19,15 @@ struct DisplayInfo {
     std::string friendlyName;   // Monitor friendly name (UTF-8)
     std::string sourceName;     // GDI source name: \\.\DISPLAY1
     bool isPrimary = false;
+    std::vector<ModeInfo> edidModes; // Monitor-advertised modes, filled by listModes from EDID
+    int edidMaxHz = 0;          // EDID range-limits max refresh, 0 if absent or not read
 };
 
-struct ModeInfo {
-    int width = 0;
-    int height = 0;
-    int hz = 0;
-    int orientation = 0;     // DMDO_*
-    int bitsPerPel = 0;
+// Where listModes takes modes from.
+enum class ModeSource {
+    Driver,     // EnumDisplaySettings on the GDI source
+    Edid,       // Monitor EDID/DisplayID from the registry (bitsPerPel is 0)
+    Both,       // Union of the two; driver entries win on duplicates, keeping the EDID native flag
 };
 
 struct ApplyRequest {
@@ -35,21 +38,73 @@ struct ApplyRequest {
     int orientation = -1;      // DMDO_*
     bool persist = false;
     bool dryRun = false;
+    int confirmWithin = 0;     // >0: journal an Await and refuse to apply if the journal can't be written;
+                               // `persist` is deferred until the change is confirmed
 };
 
 struct ApplyResult {
     bool success = false;
     bool changed = false;
+    bool applied = false;      // The driver accepted the change, even if verification then failed
     std::string message;
+    UINT32 journalSeq = 0;     // Undo journal entry for this change, 0 if none
+};
+
+// The DisplayConfig calls the topology query depends on. The default forwards to
+// Win32; tests substitute a simulated topology.
+class DisplayConfigBackend {
+public:
+    virtual ~DisplayConfigBackend() = default;
+    virtual LONG getBufferSizes(UINT32 flags, UINT32* numPaths, UINT32* numModes) = 0;
+    virtual LONG queryConfig(UINT32 flags, UINT32* numPaths, DISPLAYCONFIG_PATH_INFO* paths,
+                             UINT32* numModes, DISPLAYCONFIG_MODE_INFO* modes) = 0;
+    virtual LONG getDeviceInfo(DISPLAYCONFIG_DEVICE_INFO_HEADER* header) = 0;
+};
+
+// Backend calling GetDisplayConfigBufferSizes / QueryDisplayConfig / DisplayConfigGetDeviceInfo.
+DisplayConfigBackend& win32DisplayConfigBackend();
+
+// Reusable state for repeated topology queries. The path/mode buffers only grow,
+// output entries are overwritten in place, and entries dropped when the topology
+// shrinks are parked in `spare` and reused when it grows back. Once warmed up, a
+// re-query through the same context performs no heap allocation.
+struct DisplayQueryContext {
+    explicit DisplayQueryContext(DisplayConfigBackend& backend = win32DisplayConfigBackend())
+        : backend(&backend) {}
+
+    DisplayConfigBackend* backend;
+    std::vector<DISPLAYCONFIG_PATH_INFO> paths;
+    std::vector<DISPLAYCONFIG_MODE_INFO> modes;
+    std::vector<DisplayInfo> spare;
+
+    // Raw EDID per monitor device path, read from the registry at most once per context.
+    struct EdidEntry {
+        std::wstring devicePath;
+        bool found = false;
+        std::vector<unsigned char> blob;
+    };
+    std::vector<EdidEntry> edid;
 };
 
 // Query active displays with stable identifiers and names.
 bool listDisplays(std::vector<DisplayInfo>& out, std::string& errorMessage);
 
+// Same as above, reusing the buffers in `ctx`. Retries if the topology changes
+// between sizing and querying.
+bool listDisplays(DisplayQueryContext& ctx, std::vector<DisplayInfo>& out, std::string& errorMessage);
+
 // Enumerate available modes for a given source device name (e.g., \\.\DISPLAY1).
 bool listModes(const std::string& sourceName, std::vector<ModeInfo>& out, std::string& errorMessage);
 
+// Enumerate modes for a display from the driver, its EDID, or both. EDID-derived
+// modes are also stored in display.edidModes. Output is sorted and deduplicated.
+// With ModeSource::Both a missing or unparseable EDID is not an error: the driver
+// modes are returned and errorMessage is left holding a warning.
+bool listModes(DisplayQueryContext& ctx, DisplayInfo& display, ModeSource source,
+               std::vector<ModeInfo>& out, std::string& errorMessage);
+
 // Apply a mode change using Win32 Display Settings API with validation and optional persistence.
+// Non-dry-run changes record the pre-change settings in the undo journal first.
 bool applyMode(const ApplyRequest& req, ApplyResult& result);
 
 } // namespace drt
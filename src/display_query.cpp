@@ -0,0 +1,86 @@
+#include "display_config.h"
+#include "util.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Number of size/query rounds before giving up on a topology that keeps changing.
+static constexpr int kMaxQueryAttempts = 4;
+
+static bool getTargetFriendlyName(drt::DisplayConfigBackend& backend, const DISPLAYCONFIG_PATH_INFO& path,
+                                  std::string& out) {
+    DISPLAYCONFIG_TARGET_DEVICE_NAME name = {};
+    name.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_NAME;
+    name.header.size = sizeof(name);
+    name.header.adapterId = path.targetInfo.adapterId;
+    name.header.id = path.targetInfo.id;
+    if (backend.getDeviceInfo(&name.header) != ERROR_SUCCESS) { out.clear(); return false; }
+
+    drt::to_utf8(name.monitorFriendlyDeviceName, out);
+    return !out.empty();
+}
+
+static bool getSourceDeviceName(drt::DisplayConfigBackend& backend, const DISPLAYCONFIG_PATH_INFO& path,
+                                std::string& out) {
+    DISPLAYCONFIG_SOURCE_DEVICE_NAME src = {};
+    src.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
+    src.header.size = sizeof(src);
+    src.header.adapterId = path.sourceInfo.adapterId;
+    src.header.id = path.sourceInfo.id;
+    if (backend.getDeviceInfo(&src.header) != ERROR_SUCCESS) { out.clear(); return false; }
+    drt::to_utf8(src.viewGdiDeviceName, out);
+    return !out.empty();
+}
+
+bool drt::listDisplays(drt::DisplayQueryContext& ctx, std::vector<drt::DisplayInfo>& out, std::string& errorMessage) {
+    DisplayConfigBackend& backend = *ctx.backend;
+    UINT32 pathCount = 0, modeCount = 0;
+    LONG st = ERROR_INSUFFICIENT_BUFFER;
+    for (int attempt = 0; attempt < kMaxQueryAttempts && st == ERROR_INSUFFICIENT_BUFFER; ++attempt) {
+        st = backend.getBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount);
+        if (st != ERROR_SUCCESS) { errorMessage = "GetDisplayConfigBufferSizes failed"; return false; }
+        // Grow only; QueryDisplayConfig accepts larger buffers and reports the used counts.
+        if (ctx.paths.size() < pathCount) ctx.paths.resize(pathCount);
+        if (ctx.modes.size() < modeCount) ctx.modes.resize(modeCount);
+        pathCount = static_cast<UINT32>(ctx.paths.size());
+        modeCount = static_cast<UINT32>(ctx.modes.size());
+        st = backend.queryConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, ctx.paths.data(), &modeCount, ctx.modes.data());
+    }
+    if (st != ERROR_SUCCESS) {
+        errorMessage = (st == ERROR_INSUFFICIENT_BUFFER) ? "QueryDisplayConfig failed (topology kept changing)"
+                                                         : "QueryDisplayConfig failed";
+        return false;
+    }
+
+    // Resize through the spare pool so entries keep their string capacity across
+    // topology changes.
+    while (out.size() > pathCount) {
+        ctx.spare.push_back(std::move(out.back()));
+        out.pop_back();
+    }
+    while (out.size() < pathCount) {
+        if (ctx.spare.empty()) {
+            out.emplace_back();
+        } else {
+            out.push_back(std::move(ctx.spare.back()));
+            ctx.spare.pop_back();
+        }
+    }
+    for (UINT32 i = 0; i < pathCount; ++i) {
+        const auto& p = ctx.paths[i];
+        DisplayInfo& info = out[i];
+        info.id.adapterLuid = p.targetInfo.adapterId;
+        info.id.targetId = p.targetInfo.id;
+        info.isPrimary = (p.sourceInfo.id == 0);
+        getTargetFriendlyName(backend, p, info.friendlyName);
+        getSourceDeviceName(backend, p, info.sourceName);
+        info.edidModes.clear();
+        info.edidMaxHz = 0;
+    }
+    if (out.empty()) {
+        errorMessage = "No active displays found";
+        return false;
+    }
+    return true;
+}
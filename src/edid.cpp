@@ -0,0 +1,221 @@
+#include "edid.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr size_t kBlockSize = 128;
+
+// Read-only window over part of the blob. Out-of-range reads return 0, so a
+// truncated structure decodes as "absent" instead of reading past the end.
+struct Bytes {
+    const uint8_t* p = nullptr;
+    size_t n = 0;
+
+    uint8_t at(size_t i) const { return i < n ? p[i] : 0; }
+    uint32_t le16(size_t i) const { return at(i) | (uint32_t(at(i + 1)) << 8); }
+    uint32_t le24(size_t i) const { return le16(i) | (uint32_t(at(i + 2)) << 16); }
+    Bytes sub(size_t off, size_t len) const {
+        if (off >= n) return {};
+        return {p + off, std::min(len, n - off)};
+    }
+};
+
+struct EstablishedTiming {
+    size_t byte;
+    int bit;
+    int width, height, hz;
+};
+
+// Established timings I/II and the manufacturer bit (interlaced 1024x768@87 omitted).
+const EstablishedTiming kEstablished[] = {
+    {35, 7, 720, 400, 70},  {35, 6, 720, 400, 88},  {35, 5, 640, 480, 60},   {35, 4, 640, 480, 67},
+    {35, 3, 640, 480, 72},  {35, 2, 640, 480, 75},  {35, 1, 800, 600, 56},   {35, 0, 800, 600, 60},
+    {36, 7, 800, 600, 72},  {36, 6, 800, 600, 75},  {36, 5, 832, 624, 75},   {36, 3, 1024, 768, 60},
+    {36, 2, 1024, 768, 70}, {36, 1, 1024, 768, 75}, {36, 0, 1280, 1024, 75}, {37, 7, 1152, 870, 75},
+};
+
+struct VicTiming {
+    uint8_t vic;
+    int width, height, hz;
+};
+
+// Progressive CTA-861 video identification codes in common use.
+const VicTiming kVics[] = {
+    {1, 640, 480, 60},     {2, 720, 480, 60},     {3, 720, 480, 60},     {4, 1280, 720, 60},
+    {16, 1920, 1080, 60},  {17, 720, 576, 50},    {18, 720, 576, 50},    {19, 1280, 720, 50},
+    {31, 1920, 1080, 50},  {32, 1920, 1080, 24},  {33, 1920, 1080, 25},  {34, 1920, 1080, 30},
+    {60, 1280, 720, 24},   {61, 1280, 720, 25},   {62, 1280, 720, 30},   {63, 1920, 1080, 120},
+    {64, 1920, 1080, 100}, {93, 3840, 2160, 24},  {94, 3840, 2160, 25},  {95, 3840, 2160, 30},
+    {96, 3840, 2160, 50},  {97, 3840, 2160, 60},  {98, 4096, 2160, 24},  {99, 4096, 2160, 25},
+    {100, 4096, 2160, 30}, {101, 4096, 2160, 50}, {102, 4096, 2160, 60}, {117, 3840, 2160, 100},
+    {118, 3840, 2160, 120},
+};
+
+} // namespace
+
+static bool blockChecksumOk(Bytes block) {
+    if (block.n < kBlockSize) return false;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < kBlockSize; ++i) sum = static_cast<uint8_t>(sum + block.at(i));
+    return sum == 0;
+}
+
+static int refreshHz(uint64_t pixelClockHz, uint64_t htotal, uint64_t vtotal) {
+    uint64_t frame = htotal * vtotal;
+    if (frame == 0) return 0;
+    return static_cast<int>((pixelClockHz + frame / 2) / frame);
+}
+
+static void addMode(drt::EdidInfo& out, int width, int height, int hz, bool preferred) {
+    if (width <= 0 || height <= 0 || hz <= 0) return;
+    drt::EdidMode m;
+    m.width = width;
+    m.height = height;
+    m.hz = hz;
+    m.preferred = preferred;
+    out.modes.push_back(m);
+}
+
+// 18-byte detailed timing descriptor (base block and CTA-861 extensions).
+static void parseDetailedTiming(Bytes d, bool preferred, drt::EdidInfo& out) {
+    uint32_t clock10k = d.le16(0);
+    if (clock10k == 0 || d.n < 18) return;
+    if (d.at(17) & 0x80) return; // interlaced
+    uint32_t hActive = d.at(2) | ((uint32_t(d.at(4)) & 0xF0) << 4);
+    uint32_t hBlank = d.at(3) | ((uint32_t(d.at(4)) & 0x0F) << 8);
+    uint32_t vActive = d.at(5) | ((uint32_t(d.at(7)) & 0xF0) << 4);
+    uint32_t vBlank = d.at(6) | ((uint32_t(d.at(7)) & 0x0F) << 8);
+    int hz = refreshHz(uint64_t(clock10k) * 10000, hActive + hBlank, vActive + vBlank);
+    addMode(out, static_cast<int>(hActive), static_cast<int>(vActive), hz, preferred);
+}
+
+// 2-byte standard timing; EDID < 1.3 encodes aspect 00 as 1:1 rather than 16:10.
+static void parseStandardTiming(uint8_t b0, uint8_t b1, bool legacyAspect, drt::EdidInfo& out) {
+    if (b0 == 0x00 || (b0 == 0x01 && b1 == 0x01)) return; // unused slot
+    int width = (b0 + 31) * 8;
+    int height = 0;
+    switch (b1 >> 6) {
+        case 0: height = legacyAspect ? width : width * 10 / 16; break;
+        case 1: height = width * 3 / 4; break;
+        case 2: height = width * 4 / 5; break;
+        default: height = width * 9 / 16; break;
+    }
+    addMode(out, width, height, (b1 & 0x3F) + 60, false);
+}
+
+static void parseBaseBlock(Bytes b, drt::EdidInfo& out) {
+    uint32_t mfg = (uint32_t(b.at(8)) << 8) | b.at(9);
+    out.manufacturer.clear();
+    out.manufacturer.push_back(static_cast<char>('@' + ((mfg >> 10) & 0x1F)));
+    out.manufacturer.push_back(static_cast<char>('@' + ((mfg >> 5) & 0x1F)));
+    out.manufacturer.push_back(static_cast<char>('@' + (mfg & 0x1F)));
+    out.productCode = static_cast<uint16_t>(b.le16(10));
+    bool legacyAspect = b.at(18) == 1 && b.at(19) < 3;
+    bool rev14 = b.at(18) == 1 && b.at(19) >= 4;
+
+    for (const auto& t : kEstablished) {
+        if (b.at(t.byte) & (1u << t.bit)) addMode(out, t.width, t.height, t.hz, false);
+    }
+    for (size_t i = 38; i < 54; i += 2) parseStandardTiming(b.at(i), b.at(i + 1), legacyAspect, out);
+
+    for (size_t k = 0; k < 4; ++k) {
+        Bytes d = b.sub(54 + 18 * k, 18);
+        if (d.le16(0) != 0) {
+            parseDetailedTiming(d, k == 0, out);
+            continue;
+        }
+        switch (d.at(3)) {
+            case 0xFD: // range limits; EDID 1.4 may add a 255 Hz offset
+                out.maxHz = d.at(6) + ((rev14 && (d.at(4) & 0x02)) ? 255 : 0);
+                break;
+            case 0xFC: { // monitor name, 0x0A-terminated, space padded
+                out.name.clear();
+                for (size_t i = 5; i < 18 && d.at(i) != 0x0A; ++i) out.name.push_back(static_cast<char>(d.at(i)));
+                while (!out.name.empty() && out.name.back() == ' ') out.name.pop_back();
+                break;
+            }
+            case 0xFA: // additional standard timings
+                for (size_t i = 5; i + 1 < 17; i += 2) parseStandardTiming(d.at(i), d.at(i + 1), legacyAspect, out);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void parseCtaBlock(Bytes b, drt::EdidInfo& out) {
+    size_t dtdStart = b.at(2);
+    if (dtdStart < 4 || dtdStart >= kBlockSize) return;
+
+    // Data block collection: video data blocks list VICs.
+    for (size_t i = 4; i < dtdStart;) {
+        uint8_t header = b.at(i);
+        size_t len = header & 0x1F;
+        if (header >> 5 == 2) {
+            for (size_t j = 1; j <= len && i + j < dtdStart; ++j) {
+                uint8_t svd = b.at(i + j);
+                bool native = svd >= 129 && svd <= 192;
+                uint8_t vic = native ? static_cast<uint8_t>(svd & 0x7F) : svd;
+                for (const auto& v : kVics) {
+                    if (v.vic == vic) { addMode(out, v.width, v.height, v.hz, native); break; }
+                }
+            }
+        }
+        i += 1 + len;
+    }
+
+    for (size_t off = dtdStart; off + 18 < kBlockSize; off += 18) {
+        Bytes d = b.sub(off, 18);
+        if (d.le16(0) == 0) break;
+        parseDetailedTiming(d, false, out);
+    }
+}
+
+// DisplayID section embedded in an EDID extension block (tag 0x70).
+static void parseDisplayIdBlock(Bytes b, drt::EdidInfo& out) {
+    size_t end = std::min<size_t>(5 + b.at(2), kBlockSize - 1);
+    for (size_t i = 5; i + 3 <= end;) {
+        uint8_t tag = b.at(i);
+        size_t len = b.at(i + 2);
+        if (tag == 0) break; // padding
+        // Type I (DisplayID 1.x, 10 kHz clock) and Type VII (2.x, 1 kHz clock) timings.
+        if (tag == 0x03 || tag == 0x22) {
+            uint64_t unit = (tag == 0x03) ? 10000 : 1000;
+            for (size_t off = i + 3; off + 20 <= i + 3 + len && off + 20 <= end; off += 20) {
+                Bytes d = b.sub(off, 20);
+                if (d.at(3) & 0x10) continue; // interlaced
+                uint64_t clock = (uint64_t(d.le24(0)) + 1) * unit;
+                uint32_t hActive = d.le16(4) + 1, hBlank = d.le16(6) + 1;
+                uint32_t vActive = d.le16(12) + 1, vBlank = d.le16(14) + 1;
+                addMode(out, static_cast<int>(hActive), static_cast<int>(vActive),
+                        refreshHz(clock, hActive + hBlank, vActive + vBlank), (d.at(3) & 0x80) != 0);
+            }
+        }
+        i += 3 + len;
+    }
+}
+
+bool drt::parseEdid(const uint8_t* data, size_t size, drt::EdidInfo& out, std::string& errorMessage) {
+    static const uint8_t kHeader[8] = {0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00};
+    out = {};
+    Bytes all{data, data ? size : 0};
+    Bytes base = all.sub(0, kBlockSize);
+    if (base.n < kBlockSize) { errorMessage = "EDID shorter than one block"; return false; }
+    if (!std::equal(kHeader, kHeader + 8, base.p)) { errorMessage = "Missing EDID header"; return false; }
+    if (!blockChecksumOk(base)) { errorMessage = "EDID base block checksum mismatch"; return false; }
+
+    parseBaseBlock(base, out);
+
+    size_t extensions = base.at(126);
+    for (size_t k = 1; k <= extensions; ++k) {
+        Bytes ext = all.sub(k * kBlockSize, kBlockSize);
+        if (!blockChecksumOk(ext)) continue;
+        switch (ext.at(0)) {
+            case 0x02: parseCtaBlock(ext, out); break;
+            case 0x70: parseDisplayIdBlock(ext, out); break;
+            default: break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// EDID / DisplayID decoder. Reads the monitor-advertised timings straight out of
+// the raw blob (no copy of the input) with every access bounds-checked, so it is
+// safe on truncated or corrupt data. Win32-free.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace drt {
+
+struct EdidMode {
+    int width = 0;
+    int height = 0;
+    int hz = 0;              // rounded to the nearest integer
+    bool preferred = false;  // first detailed timing / DisplayID preferred flag
+};
+
+struct EdidInfo {
+    std::string manufacturer;   // 3-letter PNP id, e.g. "DEL"
+    uint16_t productCode = 0;
+    std::string name;           // monitor name descriptor, if present
+    int maxHz = 0;              // range limits descriptor, 0 if absent
+    std::vector<EdidMode> modes;
+};
+
+// Decode the base block plus any CTA-861 and DisplayID extension blocks. Blocks
+// that are truncated or fail their checksum are skipped; only a bad base block
+// is an error.
+bool parseEdid(const uint8_t* data, size_t size, EdidInfo& out, std::string& errorMessage);
+
+} // namespace drt
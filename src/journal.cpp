@@ -0,0 +1,430 @@
+#include "journal.h"
+
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+static const char kJournalMagic[4] = {'D', 'M', 'J', 'R'};
+static constexpr uint16_t kJournalVersion = 1;
+// Records fetched per read while walking back from the tail.
+static constexpr size_t kReadChunkRecords = 32;
+
+namespace {
+
+// A locked journal, read back from its tail a chunk at a time; releases the lock
+// on scope exit.
+struct Journal {
+    drt::JournalStore& store;
+    bool locked = false;
+    bool readFailed = false;
+    size_t fileRecords = 0;                 // whole records in the file, valid or not
+    size_t chunkStart = 0;                  // file index of chunk[0]
+    std::vector<drt::JournalRecord> chunk;  // last block read, unvalidated
+
+    explicit Journal(drt::JournalStore& s) : store(s) {}
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    ~Journal() { if (locked) store.unlock(); }
+};
+
+// Everything the journal holds about one change.
+struct ChangeState {
+    bool found = false;          // its Begin record was read
+    drt::JournalRecord begin;
+    bool ended = false;
+    int32_t result = 0;          // End: DISP_CHANGE_*
+    bool awaiting = false;
+    int64_t deadline = 0;
+    uint32_t deferredFlags = 0;  // from the Await
+    bool confirmed = false;
+    uint32_t confirmedFlags = 0; // from the Confirm
+    bool reverted = false;
+};
+
+} // namespace
+
+static uint32_t fnv1a(const void* data, size_t n) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool validRecord(drt::JournalRecord& r) {
+    if (std::memcmp(r.magic, kJournalMagic, sizeof(kJournalMagic)) != 0 || r.version != kJournalVersion) return false;
+    if (r.checksum != fnv1a(&r, offsetof(drt::JournalRecord, checksum))) return false;
+    r.sourceName[CCHDEVICENAME - 1] = '\0';
+    return true;
+}
+
+// Lock the journal. Writers drop a partial record left by a crash mid-append so
+// later appends stay aligned.
+static bool openJournal(Journal& j, bool forWrite) {
+    if (!j.store.lock()) return false;
+    j.locked = true;
+    uint64_t size = 0;
+    if (!j.store.size(size)) return false;
+    j.fileRecords = static_cast<size_t>(size / sizeof(drt::JournalRecord));
+    if (forWrite && size % sizeof(drt::JournalRecord) != 0
+        && !j.store.truncate(j.fileRecords * sizeof(drt::JournalRecord))) {
+        return false;
+    }
+    return true;
+}
+
+// Record `i` of the file, reading the chunk that ends at it if it is not cached.
+// False if it fails validation or cannot be read (then readFailed is set).
+static bool recordAt(Journal& j, size_t i, drt::JournalRecord& r) {
+    if (i < j.chunkStart || i >= j.chunkStart + j.chunk.size()) {
+        size_t start = i + 1 > kReadChunkRecords ? i + 1 - kReadChunkRecords : 0;
+        j.chunk.resize(i + 1 - start);
+        j.chunkStart = start;
+        if (!j.store.read(uint64_t(start) * sizeof(r), j.chunk.data(), j.chunk.size() * sizeof(r))) {
+            j.chunk.clear();
+            j.readFailed = true;
+            return false;
+        }
+    }
+    r = j.chunk[i - j.chunkStart];
+    return validRecord(r);
+}
+
+// Pass valid records to `visit`, newest first, until it returns false. False only
+// if the journal could not be read.
+template <typename Visit>
+static bool walkBack(Journal& j, Visit visit) {
+    for (size_t i = j.fileRecords; i-- > 0;) {
+        drt::JournalRecord r;
+        if (recordAt(j, i, r)) {
+            if (!visit(r)) break;
+        } else if (j.readFailed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static drt::JournalRecord makeRecord(drt::JournalKind kind, uint32_t seq) {
+    drt::JournalRecord r;
+    std::memset(&r, 0, sizeof(r)); // padding is covered by the checksum
+    std::memcpy(r.magic, kJournalMagic, sizeof(kJournalMagic));
+    r.version = kJournalVersion;
+    r.kind = static_cast<uint16_t>(kind);
+    r.seq = seq;
+    r.timestamp = static_cast<int64_t>(std::time(nullptr));
+    return r;
+}
+
+// Append one record; the store flushes it to disk before returning.
+static bool appendRecord(Journal& j, drt::JournalRecord& r) {
+    r.checksum = fnv1a(&r, offsetof(drt::JournalRecord, checksum));
+    if (!j.store.append(&r, sizeof(r))) return false;
+    ++j.fileRecords;
+    return true;
+}
+
+static bool isKind(const drt::JournalRecord& r, drt::JournalKind kind) {
+    return r.kind == static_cast<uint16_t>(kind);
+}
+
+static int64_t now() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+// Sequence number of the newest Begin; Begins are appended in seq order.
+static bool latestSeq(Journal& j, uint32_t& seq) {
+    seq = 0;
+    return walkBack(j, [&](const drt::JournalRecord& r) {
+        if (!isKind(r, drt::JournalKind::Begin)) return true;
+        seq = r.seq;
+        return false;
+    });
+}
+
+static void noteRecord(ChangeState& s, const drt::JournalRecord& r) {
+    switch (static_cast<drt::JournalKind>(r.kind)) {
+        case drt::JournalKind::Begin:
+            s.found = true;
+            s.begin = r;
+            break;
+        case drt::JournalKind::End:
+            s.ended = true;
+            s.result = r.result;
+            break;
+        case drt::JournalKind::Await:
+            s.awaiting = true;
+            s.deadline = r.timestamp + r.result;
+            s.deferredFlags = r.flags;
+            break;
+        case drt::JournalKind::Confirm:
+            s.confirmed = true;
+            s.confirmedFlags |= r.flags;
+            break;
+        case drt::JournalKind::Revert:
+            s.reverted = true;
+            break;
+    }
+}
+
+// Walk back to change `seq`'s Begin. A change's records never precede its Begin,
+// and Begins are in seq order, so this stops as soon as it reaches an older one.
+static bool changeState(Journal& j, uint32_t seq, ChangeState& s) {
+    s = {};
+    return walkBack(j, [&](const drt::JournalRecord& r) {
+        if (r.seq == seq) noteRecord(s, r);
+        return !(isKind(r, drt::JournalKind::Begin) && r.seq <= seq);
+    });
+}
+
+// Applied and not undone. A change with no End record (crash during apply) counts
+// as applied.
+static bool isApplied(const ChangeState& s) {
+    return s.found && !s.reverted && (!s.ended || s.result == DISP_CHANGE_SUCCESSFUL);
+}
+
+// The Begin record with the CDS_* flags the change ended up applied with.
+static drt::JournalRecord appliedChange(const ChangeState& s) {
+    drt::JournalRecord c = s.begin;
+    c.flags |= s.confirmedFlags;
+    return c;
+}
+
+// Keep only the records of the newest kJournalKeepChanges changes once the file
+// reaches kJournalMaxRecords. This is the one place the whole file is read.
+// Failure is not fatal: the journal just stays long.
+static void compactJournal(Journal& j) {
+    if (j.fileRecords < drt::kJournalMaxRecords) return;
+    std::vector<drt::JournalRecord> all(j.fileRecords);
+    if (!j.store.read(0, all.data(), all.size() * sizeof(drt::JournalRecord))) return;
+    std::vector<drt::JournalRecord> kept;
+    uint32_t latest = 0;
+    for (auto& r : all) {
+        if (validRecord(r)) latest = std::max(latest, r.seq);
+    }
+    uint32_t keepFrom = latest > drt::kJournalKeepChanges ? latest - drt::kJournalKeepChanges + 1 : 0;
+    for (auto& r : all) {
+        if (validRecord(r) && r.seq >= keepFrom) kept.push_back(r);
+    }
+    if (!j.store.replace(kept.data(), kept.size() * sizeof(drt::JournalRecord))) return;
+    j.fileRecords = kept.size();
+    j.chunk.clear();
+}
+
+uint32_t drt::journalBegin(const std::string& sourceName, const DEVMODEA& snapshot, DWORD flags, JournalStore& store) {
+    Journal j(store);
+    if (!openJournal(j, true)) return 0;
+    compactJournal(j);
+    uint32_t latest = 0;
+    if (!latestSeq(j, latest)) return 0;
+    JournalRecord r = makeRecord(JournalKind::Begin, latest + 1);
+    r.flags = static_cast<uint32_t>(flags);
+    std::memcpy(r.sourceName, sourceName.c_str(), std::min<size_t>(sourceName.size(), CCHDEVICENAME - 1));
+    r.snapshot = snapshot;
+    return appendRecord(j, r) ? r.seq : 0;
+}
+
+void drt::journalEnd(uint32_t seq, LONG result, JournalStore& store) {
+    Journal j(store);
+    if (seq == 0 || !openJournal(j, true)) return;
+    JournalRecord r = makeRecord(JournalKind::End, seq);
+    r.result = static_cast<int32_t>(result);
+    appendRecord(j, r);
+}
+
+bool drt::journalAwait(uint32_t seq, int seconds, DWORD deferredFlags, JournalStore& store) {
+    Journal j(store);
+    if (seq == 0 || !openJournal(j, true)) return false;
+    JournalRecord r = makeRecord(JournalKind::Await, seq);
+    r.result = seconds;
+    r.flags = static_cast<uint32_t>(deferredFlags);
+    return appendRecord(j, r);
+}
+
+// Awaits among the newest kJournalKeepChanges changes that are not confirmed,
+// reverted or failed, newest first.
+static bool openAwaits(Journal& j, std::vector<drt::JournalRecord>& out) {
+    std::unordered_set<uint32_t> settled;
+    uint32_t begins = 0;
+    return walkBack(j, [&](const drt::JournalRecord& r) {
+        switch (static_cast<drt::JournalKind>(r.kind)) {
+            case drt::JournalKind::Confirm:
+            case drt::JournalKind::Revert:
+                settled.insert(r.seq);
+                break;
+            case drt::JournalKind::End:
+                if (r.result != DISP_CHANGE_SUCCESSFUL) settled.insert(r.seq);
+                break;
+            case drt::JournalKind::Await:
+                if (!settled.count(r.seq)) out.push_back(r);
+                break;
+            case drt::JournalKind::Begin:
+                ++begins;
+                break;
+        }
+        return begins < drt::kJournalKeepChanges;
+    });
+}
+
+// Append the Confirm, then write the deferred registry update. Confirm goes first:
+// if the registry write fails, a later revert merely rewrites the old mode there.
+static bool confirmChange(Journal& j, const ChangeState& s, drt::SnapshotRestorer& restorer, std::string& errorMessage) {
+    drt::JournalRecord r = makeRecord(drt::JournalKind::Confirm, s.begin.seq);
+    r.flags = s.deferredFlags;
+    if (!appendRecord(j, r)) { errorMessage = "Failed to write journal"; return false; }
+    if ((s.deferredFlags & CDS_UPDATEREGISTRY) && !restorer.persist(s.begin, errorMessage)) {
+        errorMessage = "Confirmed change " + std::to_string(s.begin.seq) + " but could not persist it: " + errorMessage;
+        return false;
+    }
+    return true;
+}
+
+bool drt::journalConfirm(uint32_t& seq, std::string& errorMessage, JournalStore& store, SnapshotRestorer& restorer) {
+    Journal j(store);
+    if (!openJournal(j, true)) { errorMessage = "Failed to open journal"; return false; }
+    int64_t t = now();
+    if (seq == 0) {
+        std::vector<JournalRecord> awaits;
+        if (!openAwaits(j, awaits)) { errorMessage = "Failed to read journal"; return false; }
+        for (const auto& a : awaits) {
+            if (a.timestamp + a.result > t) { seq = a.seq; break; }
+        }
+        if (seq == 0) { errorMessage = "No change is awaiting confirmation"; return false; }
+    }
+    ChangeState s;
+    if (!changeState(j, seq, s)) { errorMessage = "Failed to read journal"; return false; }
+    const std::string change = "Change " + std::to_string(seq);
+    if (!s.found) { errorMessage = change + " not found in journal"; return false; }
+    if (s.confirmed) return true;
+    if (s.reverted) { errorMessage = change + " has been reverted"; return false; }
+    if (!s.ended || s.result != DISP_CHANGE_SUCCESSFUL) { errorMessage = change + " was not applied"; return false; }
+    if (s.awaiting && s.deadline <= t) { errorMessage = change + " was not confirmed in time"; return false; }
+    return confirmChange(j, s, restorer, errorMessage);
+}
+
+bool drt::journalIsConfirmed(uint32_t seq, JournalStore& store) {
+    Journal j(store);
+    if (!openJournal(j, false)) return false;
+    ChangeState s;
+    return changeState(j, seq, s) && s.confirmed;
+}
+
+// Walk back from the tail collecting the Begin records (newest first, flags as
+// applied) of changes that were applied and not reverted.
+static bool collectRevertable(Journal& j, size_t count, std::vector<drt::JournalRecord>& out) {
+    std::unordered_set<uint32_t> skip;                    // reverted or failed
+    std::unordered_map<uint32_t, uint32_t> confirmedFlags;
+    return walkBack(j, [&](const drt::JournalRecord& r) {
+        switch (static_cast<drt::JournalKind>(r.kind)) {
+            case drt::JournalKind::Revert:
+                skip.insert(r.seq);
+                break;
+            case drt::JournalKind::End:
+                if (r.result != DISP_CHANGE_SUCCESSFUL) skip.insert(r.seq);
+                break;
+            case drt::JournalKind::Confirm:
+                confirmedFlags[r.seq] |= r.flags;
+                break;
+            case drt::JournalKind::Begin:
+                if (skip.count(r.seq)) break;
+                out.push_back(r);
+                if (auto it = confirmedFlags.find(r.seq); it != confirmedFlags.end()) out.back().flags |= it->second;
+                break;
+            default:
+                break;
+        }
+        return out.size() < count;
+    });
+}
+
+// Restore snapshots (newest first). Only the oldest snapshot per display is applied,
+// since that is the state the display ends up in; it goes to the registry if any of
+// that display's changes did. Revert records are written only once every restore
+// succeeded, so a failed or interrupted revert can be retried.
+static bool restoreSnapshots(Journal& j, drt::SnapshotRestorer& restorer, const std::vector<drt::JournalRecord>& changes,
+                             std::string& message) {
+    for (size_t i = 0; i < changes.size(); ++i) {
+        const auto& c = changes[i];
+        bool superseded = false;
+        for (size_t k = i + 1; k < changes.size() && !superseded; ++k) {
+            superseded = std::strcmp(changes[k].sourceName, c.sourceName) == 0;
+        }
+        if (superseded) continue;
+        drt::JournalRecord oldest = c;
+        for (size_t k = 0; k < i; ++k) {
+            if (std::strcmp(changes[k].sourceName, c.sourceName) == 0) oldest.flags |= changes[k].flags & CDS_UPDATEREGISTRY;
+        }
+        if (!restorer.restore(oldest, message)) return false;
+    }
+    for (const auto& c : changes) {
+        drt::JournalRecord r = makeRecord(drt::JournalKind::Revert, c.seq);
+        if (!appendRecord(j, r)) {
+            message = "Reverted " + std::to_string(changes.size()) + " change(s) but failed to record it in the journal";
+            return false;
+        }
+    }
+    message = "Reverted " + std::to_string(changes.size()) + " change(s)";
+    return true;
+}
+
+bool drt::revertChanges(int count, std::string& message, JournalStore& store, SnapshotRestorer& restorer) {
+    Journal j(store);
+    if (count <= 0) { message = "Nothing to revert"; return false; }
+    if (!openJournal(j, true)) { message = "Failed to open journal"; return false; }
+    std::vector<JournalRecord> changes;
+    if (!collectRevertable(j, static_cast<size_t>(count), changes)) { message = "Failed to read journal"; return false; }
+    if (changes.empty()) { message = "No changes to revert"; return false; }
+    return restoreSnapshots(j, restorer, changes, message);
+}
+
+bool drt::revertUnconfirmed(const std::vector<uint32_t>& seqs, bool& confirmed, std::string& message,
+                            JournalStore& store, SnapshotRestorer& restorer) {
+    confirmed = false;
+    Journal j(store);
+    if (!openJournal(j, true)) { message = "Failed to open journal"; return false; }
+    std::vector<ChangeState> states(seqs.size());
+    for (size_t i = 0; i < seqs.size(); ++i) {
+        if (seqs[i] != 0 && !changeState(j, seqs[i], states[i])) { message = "Failed to read journal"; return false; }
+        confirmed = confirmed || states[i].confirmed;
+    }
+    if (confirmed) {
+        for (const auto& s : states) {
+            if (isApplied(s) && !s.confirmed && !confirmChange(j, s, restorer, message)) return false;
+        }
+        message = "Confirmed";
+        return true;
+    }
+    std::vector<JournalRecord> changes;
+    for (const auto& s : states) {
+        if (isApplied(s)) changes.push_back(appliedChange(s));
+    }
+    if (changes.empty()) { message = "Nothing to roll back"; return true; }
+    std::sort(changes.begin(), changes.end(), [](const JournalRecord& a, const JournalRecord& b) { return a.seq > b.seq; });
+    return restoreSnapshots(j, restorer, changes, message);
+}
+
+bool drt::revertExpired(int64_t notBefore, std::string& message, JournalStore& store, SnapshotRestorer& restorer) {
+    message.clear();
+    Journal j(store);
+    if (!openJournal(j, true)) { message = "Failed to open journal"; return false; }
+    std::vector<JournalRecord> awaits;
+    if (!openAwaits(j, awaits)) { message = "Failed to read journal"; return false; }
+    int64_t t = now();
+    std::vector<JournalRecord> changes;
+    for (const auto& a : awaits) {
+        if (a.timestamp < notBefore || a.timestamp + a.result > t) continue;
+        ChangeState s;
+        if (!changeState(j, a.seq, s)) { message = "Failed to read journal"; return false; }
+        if (isApplied(s)) changes.push_back(appliedChange(s));
+    }
+    if (changes.empty()) return true;
+    if (!restoreSnapshots(j, restorer, changes, message)) return false;
+    message += " left unconfirmed by an interrupted run";
+    return true;
+}
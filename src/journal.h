@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+namespace drt {
+
+// Append-only journal of display mode changes, kept in
+// %LOCALAPPDATA%\displaymode\journal.bin (falls back to %TEMP%).
+//
+// Every change appends a Begin record holding the pre-change DEVMODEA before the
+// driver is called, then an End record with the result. Records are fixed-size
+// and checksummed, each append is flushed to disk, and a torn tail left by a
+// crash is truncated on the next open, so the file stays readable. Operations
+// read back from the end only as far as the records they need; records that fail
+// validation are skipped. Every operation holds the store's cross-process lock
+// from its first read to its last append, so concurrent instances never
+// interleave sequence numbers or act on a stale view of a change.
+enum class JournalKind : uint16_t {
+    Begin = 1,      // snapshot taken, about to apply
+    End = 2,        // apply returned `result`
+    Confirm = 3,    // change confirmed (see --confirm-within); `flags` as persisted on confirm
+    Revert = 4,     // change undone; no longer a revert candidate
+    Await = 5,      // change must be confirmed within `result` seconds of `timestamp`;
+                    // `flags` are the CDS_* flags deferred until then
+};
+
+struct JournalRecord {
+    char magic[4];                    // "DMJR"
+    uint16_t version;
+    uint16_t kind;                    // JournalKind
+    uint32_t seq;                     // change this record belongs to
+    int32_t result;                   // End: DISP_CHANGE_* code; Await: seconds to confirm
+    int64_t timestamp;                // seconds since the Unix epoch
+    uint32_t flags;                   // CDS_* flags the change was applied with
+    char sourceName[CCHDEVICENAME];   // \\.\DISPLAYn
+    DEVMODEA snapshot;                // Begin: settings before the change
+    uint32_t checksum;                // FNV-1a over all preceding bytes
+};
+
+// Once the file holds this many records it is compacted on the next Begin down to
+// the records of the newest kJournalKeepChanges changes. Searches that are not
+// for a known seq (confirm without SEQ, revertExpired) look no further back either.
+constexpr size_t kJournalMaxRecords = 1024;
+constexpr uint32_t kJournalKeepChanges = 64;
+
+// Storage for the journal file. The Win32 implementation is the real file under a
+// lock file; tests substitute an in-memory one.
+class JournalStore {
+public:
+    virtual ~JournalStore() = default;
+    // Take / release the cross-process lock that guards every call below.
+    virtual bool lock() = 0;
+    virtual void unlock() = 0;
+    // Size of the journal in bytes; a missing journal is empty.
+    virtual bool size(uint64_t& out) = 0;
+    // Read exactly `size` bytes starting at `offset`.
+    virtual bool read(uint64_t offset, void* out, size_t size) = 0;
+    // Cut the journal to `size` bytes (drops a torn tail).
+    virtual bool truncate(uint64_t size) = 0;
+    // Append at the end of the file and flush to disk; false unless both succeed.
+    virtual bool append(const void* data, size_t size) = 0;
+    // Atomically replace the whole journal (compaction).
+    virtual bool replace(const void* data, size_t size) = 0;
+};
+
+// Applies journal records back to their display.
+class SnapshotRestorer {
+public:
+    virtual ~SnapshotRestorer() = default;
+    // Apply a Begin record's snapshot, also to the registry if `change.flags` has
+    // CDS_UPDATEREGISTRY.
+    virtual bool restore(const JournalRecord& change, std::string& errorMessage) = 0;
+    // Save the display's current mode to the registry without switching modes; used
+    // on confirmation of a change whose CDS_UPDATEREGISTRY was deferred.
+    virtual bool persist(const JournalRecord& change, std::string& errorMessage) = 0;
+};
+
+// The journal file and ChangeDisplaySettingsEx-based restore.
+JournalStore& win32JournalStore();
+SnapshotRestorer& win32SnapshotRestorer();
+
+// Record the state of `sourceName` before a change. Returns the change's sequence
+// number, or 0 if the journal could not be written.
+uint32_t journalBegin(const std::string& sourceName, const DEVMODEA& snapshot, DWORD flags,
+                      JournalStore& store = win32JournalStore());
+
+// Record the outcome of change `seq`.
+void journalEnd(uint32_t seq, LONG result, JournalStore& store = win32JournalStore());
+
+// Record that change `seq` is reverted unless confirmed within `seconds`, and
+// that `deferredFlags` (CDS_UPDATEREGISTRY) are to be applied on confirmation.
+bool journalAwait(uint32_t seq, int seconds, DWORD deferredFlags, JournalStore& store = win32JournalStore());
+
+// Mark change `seq` as confirmed and persist it if its registry update was
+// deferred. With seq 0, the newest change that is awaiting confirmation, is not
+// yet confirmed or reverted, and whose deadline has not passed. Changes that
+// failed, were reverted or ran out of time are refused; an already confirmed one
+// succeeds without writing again. Returns the confirmed seq in `seq`.
+bool journalConfirm(uint32_t& seq, std::string& errorMessage, JournalStore& store = win32JournalStore(),
+                    SnapshotRestorer& restorer = win32SnapshotRestorer());
+
+// True once a Confirm record for `seq` exists.
+bool journalIsConfirmed(uint32_t seq, JournalStore& store = win32JournalStore());
+
+// Undo the `count` most recent applied, not yet reverted changes by restoring their
+// snapshots directly; each display ends up in its state before the oldest of them,
+// written to the registry if any of its reverted changes was.
+bool revertChanges(int count, std::string& message, JournalStore& store = win32JournalStore(),
+                   SnapshotRestorer& restorer = win32SnapshotRestorer());
+
+// Automatic rollback of the changes of one --confirm-within run, decided under a
+// single lock. If any of them is confirmed, the group is kept: the others are
+// confirmed too and `confirmed` is set. Otherwise every one still applied is
+// undone. Changes already reverted are left alone.
+bool revertUnconfirmed(const std::vector<uint32_t>& seqs, bool& confirmed, std::string& message,
+                       JournalStore& store = win32JournalStore(), SnapshotRestorer& restorer = win32SnapshotRestorer());
+
+// Undo changes whose confirmation deadline has passed without a Confirm, e.g.
+// because the waiting process was killed. Awaits written before `notBefore` (the
+// last boot: their changes were never persisted) are ignored. `message` is left
+// empty if there was nothing to do.
+bool revertExpired(int64_t notBefore, std::string& message, JournalStore& store = win32JournalStore(),
+                   SnapshotRestorer& restorer = win32SnapshotRestorer());
+
+} // namespace drt
@@ -3,10 +3,20 @@
 #include <vector>
 #include <cstdlib>
 #include <cctype>
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <io.h>
 
 #include "cli.h"
 #include "windows_display.h"
 #include "display_config.h"
+#include "output_format.h"
+#include "journal.h"
 #include "util.h"
 #include "version.h"
 
@@ -17,6 +27,104 @@ static bool parseIndex(const std::string& s, int& out) {
     return true;
 }
 
+static void printModes(const std::vector<drt::ModeInfo>& modes, const drt::Args& a, drt::OutputFormat fmt) {
+    if (fmt == drt::OutputFormat::Text && a.quiet) return;
+    drt::writeModes(std::cout, fmt, modes);
+}
+
+static std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = s.find(',', start);
+        std::string part = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (!part.empty()) parts.push_back(part);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return parts;
+}
+
+// Changes of this run that are neither confirmed nor rolled back yet. If the console
+// is interrupted or closed meanwhile, the ctrl handler rolls them back before the
+// process ends.
+static std::mutex pendingMutex;
+static std::vector<uint32_t> pendingSeqs;
+
+static BOOL WINAPI rollBackPending(DWORD) {
+    std::lock_guard<std::mutex> guard(pendingMutex);
+    if (!pendingSeqs.empty()) {
+        bool confirmed = false;
+        std::string message;
+        drt::revertUnconfirmed(pendingSeqs, confirmed, message);
+        pendingSeqs.clear();
+    }
+    return FALSE; // go on to the default handler, which ends the process
+}
+
+// Keep or roll back the changes in `seqs` (one --apply or --apply-best run). With
+// `seconds` > 0, first wait that long for Enter on stdin or a --confirm from another
+// process; confirming one confirms the group. What is still unconfirmed then is
+// rolled back, decided under the journal lock, so a --confirm racing the deadline
+// either lands first or is refused. Returns true if the changes are kept;
+// otherwise `rolledBack` and `message` describe the rollback. The stdin reader is
+// abandoned on timeout.
+static bool settleChanges(const std::vector<uint32_t>& seqs, int seconds, bool& rolledBack, std::string& message) {
+    rolledBack = false;
+    {
+        std::lock_guard<std::mutex> guard(pendingMutex);
+        pendingSeqs = seqs;
+    }
+    SetConsoleCtrlHandler(rollBackPending, TRUE);
+
+    bool confirmed = false;
+    if (seconds > 0) {
+        auto entered = std::make_shared<std::atomic<bool>>(false);
+        std::thread([entered] {
+            std::string line;
+            if (std::getline(std::cin, line)) *entered = true;
+        }).detach();
+
+        ULONGLONG deadline = GetTickCount64() + static_cast<ULONGLONG>(seconds) * 1000;
+        for (bool last = false; !confirmed && !last;) {
+            last = GetTickCount64() >= deadline; // one more look once the time is up
+            confirmed = *entered;
+            for (size_t i = 0; i < seqs.size() && !confirmed; ++i) confirmed = drt::journalIsConfirmed(seqs[i]);
+            if (!confirmed && !last) Sleep(250);
+        }
+        if (*entered) {
+            std::string err;
+            uint32_t seq = seqs.front();
+            drt::journalConfirm(seq, err); // may be refused if the deadline just passed
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(pendingMutex);
+    if (!pendingSeqs.empty()) {
+        // Confirms the rest of the group if any of it is confirmed, else rolls back.
+        bool ok = drt::revertUnconfirmed(seqs, confirmed, message);
+        rolledBack = ok && !confirmed;
+        pendingSeqs.clear();
+    }
+    SetConsoleCtrlHandler(rollBackPending, FALSE);
+    return confirmed;
+}
+
+static void printResult(bool success, bool changed, const std::string& message, const drt::Args& a) {
+    if (a.json)
+    {
+        std::cout << "{\"success\":" << (success ? "true" : "false")
+                  << ",\"changed\":" << (changed ? "true" : "false")
+                  << ",\"message\":";
+        drt::writeJsonString(std::cout, message);
+        std::cout << "}\n";
+    }
+    else if (!a.quiet)
+    {
+        (success ? std::cout : std::cerr) << (success ? "" : "Failed: ") << message << std::endl;
+    }
+}
+
 int main(int argc, char **argv)
 {
     drt::Args a;
@@ -26,110 +134,295 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
     }
 
-    auto resolveSourceName = [&](const std::string &sel, std::string &outSource) -> bool
+    drt::OutputFormat outFormat = a.json ? drt::OutputFormat::Json : drt::OutputFormat::Text;
+    if (!a.format.empty() && !drt::parseOutputFormat(a.format, outFormat))
+    {
+        std::cerr << drt::usage(a.program) << std::endl;
+        return EXIT_FAILURE;
+    }
+    bool listing = (a.list || a.listModes || a.commonModes) && !a.applyBest && a.revert == 0 && !a.confirm;
+    if (drt::isTableOnlyFormat(outFormat) && !listing)
+    {
+        std::cerr << (a.quiet ? "" : "--format " + a.format + " is only supported for --list, --list-modes and --common-modes") << std::endl;
+        return 4;
+    }
+    if (outFormat == drt::OutputFormat::Bin)
+    {
+        // Keep the CRT from translating \n to \r\n inside binary records.
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+
+    drt::ModeSource modeSource = drt::ModeSource::Driver;
+    if (a.source == "edid") modeSource = drt::ModeSource::Edid;
+    else if (a.source == "both") modeSource = drt::ModeSource::Both;
+    if (a.applyBest)
     {
-        if (sel.rfind(R"(\\.\DISPLAY)", 0) == 0) { outSource = sel; return true; }
+        // Only apply modes the driver has listed; EDID-only timings were never validated.
+        if (modeSource == drt::ModeSource::Edid)
+        {
+            std::cerr << (a.quiet ? "" : "--apply-best needs driver-listed modes; use --source driver or both") << std::endl;
+            return 4;
+        }
+        modeSource = drt::ModeSource::Driver;
+    }
+
+    // Shared across lookups so repeated topology queries reuse their buffers.
+    drt::DisplayQueryContext queryCtx;
+    std::vector<drt::DisplayInfo> displays;
+
+    // Resolve a selector to a display. A \\.\DISPLAYn path is taken as-is unless the
+    // caller needs the target id (EDID lookups), which requires a topology query.
+    auto resolveDisplay = [&](const std::string &sel, bool needId, drt::DisplayInfo &out) -> bool
+    {
+        bool isPath = sel.rfind(R"(\\.\DISPLAY)", 0) == 0;
+        if (isPath && !needId) { out = {}; out.sourceName = sel; return true; }
+        std::string err;
+        if (!drt::listDisplays(queryCtx, displays, err)) return false;
         int idx = -1;
-        if (parseIndex(sel, idx)) {
-            std::vector<drt::DisplayInfo> displays;
-            std::string err;
-            if (!drt::listDisplays(displays, err)) return false;
+        if (!isPath && parseIndex(sel, idx)) {
             if (idx < 0 || static_cast<size_t>(idx) >= displays.size()) return false;
-            outSource = displays[static_cast<size_t>(idx)].sourceName;
+            out = displays[static_cast<size_t>(idx)];
             return true;
         }
-        // Substring match on friendly or source
-        std::vector<drt::DisplayInfo> displays;
-        std::string err;
-        if (!drt::listDisplays(displays, err)) return false;
+        // Exact source path, else substring match on friendly or source
         int match = -1;
         for (size_t i = 0; i < displays.size(); ++i) {
             const auto &d = displays[i];
-            if (d.friendlyName.find(sel) != std::string::npos || d.sourceName.find(sel) != std::string::npos) {
+            bool hit = isPath ? d.sourceName == sel
+                              : (d.friendlyName.find(sel) != std::string::npos || d.sourceName.find(sel) != std::string::npos);
+            if (hit) {
                 if (match != -1) return false; // ambiguous
                 match = static_cast<int>(i);
             }
         }
         if (match == -1) return false;
-        outSource = displays[static_cast<size_t>(match)].sourceName;
+        out = displays[static_cast<size_t>(match)];
+        return true;
+    };
+
+    auto resolveSourceName = [&](const std::string &sel, std::string &outSource) -> bool
+    {
+        drt::DisplayInfo d;
+        if (!resolveDisplay(sel, false, d)) return false;
+        outSource = d.sourceName;
         return true;
     };
 
+    // A --confirm-within run that was killed, or whose session ended, never rolled
+    // back; do it now. Changes from before the last boot were not persisted.
+    {
+        std::string message;
+        int64_t bootTime = static_cast<int64_t>(std::time(nullptr)) - static_cast<int64_t>(GetTickCount64() / 1000);
+        if (!drt::revertExpired(bootTime, message) || !message.empty())
+        {
+            std::cerr << (a.quiet ? "" : message) << std::endl;
+        }
+    }
+
+    // Undo journal flows
+    if (a.revert > 0)
+    {
+        std::string message;
+        bool ok = drt::revertChanges(a.revert, message);
+        printResult(ok, ok, message, a);
+        return ok ? 0 : 6;
+    }
+    if (a.confirm)
+    {
+        std::string err;
+        uint32_t seq = static_cast<uint32_t>(a.confirmSeq);
+        bool ok = drt::journalConfirm(seq, err);
+        printResult(ok, false, ok ? "Confirmed change " + std::to_string(seq) : err, a);
+        return ok ? 0 : 5;
+    }
+
     // Listing flows
     if (a.list || (a.listModes && !a.display.empty()))
     {
         if (a.list)
         {
-            std::vector<drt::DisplayInfo> displays;
             std::string err;
-            if (!drt::listDisplays(displays, err))
+            if (!drt::listDisplays(queryCtx, displays, err))
             {
                 std::cerr << (a.quiet ? "" : err) << std::endl;
                 return 5;
             }
-            if (a.json) {
-                std::cout << "[";
-                for (size_t i = 0; i < displays.size(); ++i) {
-                    const auto &d = displays[i];
-                    std::cout << (i? ",":"") << "{\"index\":" << i
-                              << ",\"source\":\"" << d.sourceName << "\""
-                              << ",\"name\":\"" << d.friendlyName << "\""
-                              << ",\"primary\":" << (d.isPrimary? "true":"false")
-                              << "}";
-                }
-                std::cout << "]\n";
-            } else if (!a.quiet)
+            if (outFormat != drt::OutputFormat::Text || !a.quiet)
             {
-                for (size_t i = 0; i < displays.size(); ++i)
-                {
-                    const auto &d = displays[i];
-                    std::cout << i << ": " << d.friendlyName << " [" << d.sourceName << "]" << (d.isPrimary ? " *" : "") << "\n";
-                }
+                drt::writeDisplays(std::cout, outFormat, displays);
             }
             return 0;
         }
 
         if (a.listModes)
         {
-            std::string sourceName = a.display;
-            if (!resolveSourceName(a.display, sourceName))
+            drt::DisplayInfo display;
+            if (!resolveDisplay(a.display, modeSource != drt::ModeSource::Driver, display))
             {
                 std::cerr << (a.quiet ? "" : "Display not found or ambiguous") << std::endl;
                 return 3;
             }
             std::vector<drt::ModeInfo> modes;
             std::string err;
-            if (!drt::listModes(sourceName, modes, err))
+            if (!drt::listModes(queryCtx, display, modeSource, modes, err))
             {
                 std::cerr << (a.quiet ? "" : err) << std::endl;
                 return 5;
             }
-            if (a.json)
+            if (!err.empty() && !a.quiet) std::cerr << "Warning: " << err << std::endl;
+            if (modeSource == drt::ModeSource::Driver) printModes(modes, a, outFormat);
+            else if (outFormat != drt::OutputFormat::Text || !a.quiet) drt::writeDisplayModes(std::cout, outFormat, display, modes);
+            return 0;
+        }
+    }
+
+    // Common modes across several displays (clone / video wall)
+    if (a.commonModes)
+    {
+        std::vector<drt::DisplayInfo> targets;
+        if (a.all)
+        {
+            std::string err;
+            if (!drt::listDisplays(queryCtx, displays, err))
             {
-                std::cout << "[";
-                for (size_t i = 0; i < modes.size(); ++i)
-                {
-                    const auto &m = modes[i];
-                    std::cout << (i? ",":"") << "{\"width\":" << m.width
-                              << ",\"height\":" << m.height
-                              << ",\"hz\":" << m.hz
-                              << ",\"orientation\":" << m.orientation
-                              << ",\"bpp\":" << m.bitsPerPel
-                              << "}";
-                }
-                std::cout << "]\n";
+                std::cerr << (a.quiet ? "" : err) << std::endl;
+                return 5;
             }
-            else if (!a.quiet)
+            targets = displays;
+        }
+        else
+        {
+            for (const auto &sel : splitList(a.display))
             {
-                for (const auto &m : modes)
+                drt::DisplayInfo display;
+                if (!resolveDisplay(sel, modeSource != drt::ModeSource::Driver, display))
                 {
-                    std::cout << m.width << "x" << m.height << "@" << m.hz
-                              << " bpp=" << m.bitsPerPel
-                              << " orientation=" << m.orientation << "\n";
+                    std::cerr << (a.quiet ? "" : "Display not found or ambiguous: " + sel) << std::endl;
+                    return 3;
                 }
+                targets.push_back(display);
+            }
+        }
+        if (targets.empty())
+        {
+            std::cerr << (a.quiet ? "" : "No displays selected. Use --display a,b,... or --all.") << std::endl;
+            return 4;
+        }
+
+        std::vector<std::vector<drt::ModeInfo>> lists(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            std::string err;
+            if (!drt::listModes(queryCtx, targets[i], modeSource, lists[i], err))
+            {
+                std::cerr << (a.quiet ? "" : err) << std::endl;
+                return 5;
             }
+            if (!err.empty() && !a.quiet) std::cerr << "Warning: " << err << std::endl;
+        }
+        std::vector<drt::ModeInfo> common;
+        drt::intersectModes(lists, common);
+        drt::rankModes(common);
+
+        if (!a.applyBest)
+        {
+            printModes(common, a, outFormat);
             return 0;
         }
+        if (common.empty())
+        {
+            std::cerr << (a.quiet ? "" : "No mode is supported by all selected displays") << std::endl;
+            return 5;
+        }
+
+        // Apply display by display. The group switches as a unit: if one display
+        // fails, or --confirm-within runs out, the displays already changed are
+        // rolled back through the journal, newest first.
+        const drt::ModeInfo &best = common.front();
+        struct Outcome
+        {
+            bool attempted = false;
+            bool ok = false;
+            drt::ApplyResult res;
+            std::string rollback;   // empty unless a rollback was attempted
+        };
+        std::vector<Outcome> outcomes(targets.size());
+        bool anyFailed = false;
+        for (size_t i = 0; i < targets.size() && !anyFailed; ++i)
+        {
+            drt::ApplyRequest req;
+            req.sourceName = targets[i].sourceName;
+            req.width = best.width;
+            req.height = best.height;
+            req.hz = best.hz;
+            req.persist = a.persist;
+            req.dryRun = a.dryRun;
+            req.confirmWithin = a.confirmWithin > 0 ? a.confirmWithin : 0;
+
+            outcomes[i].attempted = true;
+            outcomes[i].ok = drt::applyMode(req, outcomes[i].res);
+            anyFailed = !outcomes[i].ok;
+        }
+
+        std::vector<uint32_t> seqs;
+        for (const auto &o : outcomes)
+        {
+            if (o.res.applied && o.res.journalSeq != 0) seqs.push_back(o.res.journalSeq);
+        }
+        bool confirmed = true;
+        bool rolledBack = false;
+        std::string rollbackMessage = "nothing to roll back";
+        if ((anyFailed || a.confirmWithin > 0) && !seqs.empty())
+        {
+            if (!anyFailed && !a.quiet && !a.json)
+            {
+                std::cout << "Keep this mode on " << seqs.size() << " display(s)? Press Enter or run --confirm within "
+                          << a.confirmWithin << "s." << std::endl;
+            }
+            bool kept = settleChanges(seqs, anyFailed ? 0 : a.confirmWithin, rolledBack, rollbackMessage);
+            if (!anyFailed) confirmed = kept;
+        }
+        if (anyFailed || !confirmed)
+        {
+            // Includes displays whose change went through but failed verification.
+            for (auto &o : outcomes)
+            {
+                if (!o.res.applied) continue;
+                if (o.res.journalSeq == 0) o.rollback = "rollback failed: not in the undo journal";
+                else if (rolledBack) { o.res.changed = false; o.rollback = "rolled back"; }
+                else o.rollback = "rollback failed: " + rollbackMessage;
+            }
+        }
+
+        bool anyChanged = false;
+        if (a.json) std::cout << "[";
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            const auto &o = outcomes[i];
+            const std::string &source = targets[i].sourceName;
+            std::string message = !o.attempted ? "Skipped: an earlier display failed"
+                                : !confirmed && !o.rollback.empty() ? "Not confirmed in time; " + o.rollback
+                                : o.rollback.empty() ? o.res.message : o.res.message + "; " + o.rollback;
+            anyChanged = anyChanged || o.res.changed;
+            if (a.json)
+            {
+                std::cout << (i? ",":"") << "{\"source\":";
+                drt::writeJsonString(std::cout, source);
+                std::cout << ",\"success\":" << (o.res.success && confirmed ? "true" : "false")
+                          << ",\"changed\":" << (o.res.changed ? "true" : "false")
+                          << ",\"rolledBack\":" << (o.rollback == "rolled back" ? "true" : "false")
+                          << ",\"message\":";
+                drt::writeJsonString(std::cout, message);
+                std::cout << "}";
+            }
+            else if (!a.quiet)
+            {
+                std::cout << source << " " << best.width << "x" << best.height << "@" << best.hz << ": "
+                          << (o.ok ? "" : "Failed: ") << message << "\n";
+            }
+        }
+        if (a.json) std::cout << "]\n";
+        return (anyFailed || !confirmed) ? 6 : (anyChanged ? 0 : 2);
     }
 
     // Apply flow
@@ -154,26 +447,33 @@ int main(int argc, char **argv)
     req.orientation = a.orientation;
     req.persist = a.persist;
     req.dryRun = a.dryRun;
+    req.confirmWithin = a.confirmWithin > 0 ? a.confirmWithin : 0;
 
     drt::ApplyResult res;
     if (!drt::applyMode(req, res))
     {
-        if (a.json)
+        printResult(false, false, res.message, a);
+        return 6;
+    }
+
+    if (res.changed && a.confirmWithin > 0)
+    {
+        if (!a.quiet && !a.json)
         {
-            std::cout << "{\"success\":false,\"changed\":false,\"message\":\"" << res.message << "\"}\n";
+            std::cout << "Keep this mode? Press Enter or run --confirm " << res.journalSeq << " within " << a.confirmWithin << "s." << std::endl;
         }
-        else if (!a.quiet)
+        bool rolledBack = false;
+        std::string message;
+        if (!settleChanges({res.journalSeq}, a.confirmWithin, rolledBack, message))
         {
-            std::cerr << "Failed: " << res.message << std::endl;
+            printResult(false, !rolledBack, rolledBack ? "Not confirmed in time; reverted" : message, a);
+            return 6;
         }
-        return 6;
     }
 
     if (a.json)
     {
-        std::cout << "{\"success\":" << (res.success ? "true" : "false")
-                  << ",\"changed\":" << (res.changed ? "true" : "false")
-                  << ",\"message\":\"" << res.message << "\"}\n";
+        printResult(res.success, res.changed, res.message, a);
     }
     else if (!a.quiet)
     {
@@ -0,0 +1,57 @@
+#include "modes.h"
+
+#include <algorithm>
+
+bool drt::modeLess(const drt::ModeInfo& a, const drt::ModeInfo& b) {
+    if (a.width != b.width) return a.width < b.width;
+    if (a.height != b.height) return a.height < b.height;
+    if (a.hz != b.hz) return a.hz < b.hz;
+    return a.orientation < b.orientation;
+}
+
+bool drt::modeEqual(const drt::ModeInfo& a, const drt::ModeInfo& b) {
+    return a.width==b.width && a.height==b.height && a.hz==b.hz && a.orientation==b.orientation;
+}
+
+void drt::sortUniqueModes(std::vector<drt::ModeInfo>& modes) {
+    std::stable_sort(modes.begin(), modes.end(), modeLess);
+    size_t w = 0;
+    for (size_t i = 0; i < modes.size(); ++i) {
+        if (w > 0 && modeEqual(modes[w - 1], modes[i])) {
+            modes[w - 1].native = modes[w - 1].native || modes[i].native;
+            continue;
+        }
+        if (w != i) modes[w] = modes[i];
+        ++w;
+    }
+    modes.resize(w);
+}
+
+void drt::intersectModes(const std::vector<std::vector<drt::ModeInfo>>& lists, std::vector<drt::ModeInfo>& out) {
+    out.clear();
+    if (lists.empty()) return;
+    out = lists[0];
+    // Fold each list into the running intersection with a two-pointer merge; both
+    // sides are sorted by modeLess, so every pass is linear and the result only shrinks.
+    for (size_t k = 1; k < lists.size() && !out.empty(); ++k) {
+        const auto& other = lists[k];
+        size_t w = 0, j = 0;
+        for (size_t i = 0; i < out.size() && j < other.size(); ++i) {
+            while (j < other.size() && modeLess(other[j], out[i])) ++j;
+            if (j < other.size() && !modeLess(out[i], other[j])) out[w++] = out[i];
+        }
+        out.resize(w);
+    }
+    for (auto& m : out) m.native = false;
+}
+
+void drt::rankModes(std::vector<drt::ModeInfo>& modes) {
+    std::sort(modes.begin(), modes.end(), [](const ModeInfo& a, const ModeInfo& b){
+        long long areaA = static_cast<long long>(a.width) * a.height;
+        long long areaB = static_cast<long long>(b.width) * b.height;
+        if (areaA != areaB) return areaA > areaB;
+        if (a.width != b.width) return a.width > b.width;
+        if (a.hz != b.hz) return a.hz > b.hz;
+        return a.orientation < b.orientation;
+    });
+}
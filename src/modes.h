@@ -0,0 +1,35 @@
+#pragma once
+
+// Display mode value type and the ordering, intersection and ranking helpers
+// shared by mode listing and --common-modes. Win32-free.
+
+#include <vector>
+
+namespace drt {
+
+struct ModeInfo {
+    int width = 0;
+    int height = 0;
+    int hz = 0;
+    int orientation = 0;     // DMDO_*
+    int bitsPerPel = 0;
+    bool native = false;     // monitor's preferred/native timing (EDID sources only)
+};
+
+// Canonical mode order (width, height, refresh, orientation) and the matching identity.
+bool modeLess(const ModeInfo& a, const ModeInfo& b);
+bool modeEqual(const ModeInfo& a, const ModeInfo& b);
+
+// Sort by modeLess and drop duplicates, keeping the first of each. A kept mode is
+// native if any of its duplicates was.
+void sortUniqueModes(std::vector<ModeInfo>& modes);
+
+// Intersect mode lists sorted and deduplicated as by sortUniqueModes. Modes match
+// on width, height, refresh rate and orientation; the result keeps that order.
+// `native` is per display, so it is cleared in the result.
+void intersectModes(const std::vector<std::vector<ModeInfo>>& lists, std::vector<ModeInfo>& out);
+
+// Order modes best-first: larger resolution, then higher refresh rate.
+void rankModes(std::vector<ModeInfo>& modes);
+
+} // namespace drt
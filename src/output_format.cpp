@@ -0,0 +1,219 @@
+#include "output_format.h"
+#include "binary_format.h"
+
+#include <cstring>
+
+bool drt::parseOutputFormat(const std::string& s, drt::OutputFormat& out) {
+    if (s == "text") { out = OutputFormat::Text; return true; }
+    if (s == "json") { out = OutputFormat::Json; return true; }
+    if (s == "csv") { out = OutputFormat::Csv; return true; }
+    if (s == "ndjson") { out = OutputFormat::Ndjson; return true; }
+    if (s == "bin") { out = OutputFormat::Bin; return true; }
+    return false;
+}
+
+// RFC 4180 field: quoted, with embedded quotes doubled.
+static void writeCsvField(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"') os << '"';
+        os << c;
+    }
+    os << '"';
+}
+
+void drt::writeJsonString(std::ostream& os, const std::string& s) {
+    static const char hex[] = "0123456789abcdef";
+    os << '"';
+    for (char c : s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') os << '\\' << c;
+        else if (u < 0x20) os << "\\u00" << hex[u >> 4] << hex[u & 0xF];
+        else os << c;
+    }
+    os << '"';
+}
+
+static void appendBytes(std::string& buf, const void* p, size_t n) {
+    buf.append(static_cast<const char*>(p), n);
+}
+
+static void padTo4(std::string& buf) {
+    while (buf.size() % 4 != 0) buf.push_back('\0');
+}
+
+static drt::BinHeader makeHeader(uint16_t kind, size_t count, size_t recordSize) {
+    drt::BinHeader h = {};
+    std::memcpy(h.magic, drt::kBinMagic, sizeof(h.magic));
+    h.version = drt::kBinVersion;
+    h.kind = kind;
+    h.recordCount = static_cast<uint32_t>(count);
+    h.recordSize = static_cast<uint32_t>(recordSize);
+    h.recordsOffset = sizeof(drt::BinHeader);
+    h.stringsOffset = static_cast<uint32_t>(sizeof(drt::BinHeader) + count * recordSize);
+    return h;
+}
+
+void drt::writeDisplays(std::ostream& os, drt::OutputFormat fmt, const std::vector<drt::DisplayInfo>& displays) {
+    switch (fmt) {
+    case OutputFormat::Text:
+        for (size_t i = 0; i < displays.size(); ++i) {
+            const auto& d = displays[i];
+            os << i << ": " << d.friendlyName << " [" << d.sourceName << "]" << (d.isPrimary ? " *" : "") << "\n";
+        }
+        break;
+    case OutputFormat::Json:
+        os << "[";
+        for (size_t i = 0; i < displays.size(); ++i) {
+            const auto& d = displays[i];
+            os << (i? ",":"") << "{\"index\":" << i << ",\"source\":";
+            writeJsonString(os, d.sourceName);
+            os << ",\"name\":";
+            writeJsonString(os, d.friendlyName);
+            os << ",\"primary\":" << (d.isPrimary? "true":"false") << "}";
+        }
+        os << "]\n";
+        break;
+    case OutputFormat::Csv:
+        os << "index,source,name,primary,adapter_luid,target_id\n";
+        for (size_t i = 0; i < displays.size(); ++i) {
+            const auto& d = displays[i];
+            os << i << ',';
+            writeCsvField(os, d.sourceName);
+            os << ',';
+            writeCsvField(os, d.friendlyName);
+            os << ',' << (d.isPrimary ? 1 : 0)
+               << ',' << d.id.adapterLuid.HighPart << ':' << d.id.adapterLuid.LowPart
+               << ',' << d.id.targetId << '\n';
+        }
+        break;
+    case OutputFormat::Ndjson:
+        for (size_t i = 0; i < displays.size(); ++i) {
+            const auto& d = displays[i];
+            os << "{\"index\":" << i << ",\"source\":";
+            writeJsonString(os, d.sourceName);
+            os << ",\"name\":";
+            writeJsonString(os, d.friendlyName);
+            os << ",\"primary\":" << (d.isPrimary ? "true" : "false")
+               << ",\"adapterLuid\":\"" << d.id.adapterLuid.HighPart << ':' << d.id.adapterLuid.LowPart << "\""
+               << ",\"targetId\":" << d.id.targetId << "}\n";
+        }
+        break;
+    case OutputFormat::Bin: {
+        // Lay out the string table first so records can carry final offsets.
+        std::string strings;
+        std::vector<BinDisplayRecord> records(displays.size());
+        auto addString = [&](const std::string& s, uint32_t& offset, uint32_t& length) {
+            offset = static_cast<uint32_t>(strings.size());
+            length = static_cast<uint32_t>(s.size());
+            strings.append(s);
+            strings.push_back('\0');
+        };
+        for (size_t i = 0; i < displays.size(); ++i) {
+            const auto& d = displays[i];
+            auto& r = records[i];
+            r.adapterLuidLow = d.id.adapterLuid.LowPart;
+            r.adapterLuidHigh = d.id.adapterLuid.HighPart;
+            r.targetId = d.id.targetId;
+            r.flags = d.isPrimary ? static_cast<uint32_t>(BinDisplayPrimary) : 0u;
+            addString(d.friendlyName, r.nameOffset, r.nameLength);
+            addString(d.sourceName, r.sourceOffset, r.sourceLength);
+        }
+        padTo4(strings);
+
+        BinHeader h = makeHeader(BinKindDisplays, records.size(), sizeof(BinDisplayRecord));
+        h.stringsSize = static_cast<uint32_t>(strings.size());
+        std::string buf;
+        buf.reserve(h.stringsOffset + strings.size());
+        appendBytes(buf, &h, sizeof(h));
+        appendBytes(buf, records.data(), records.size() * sizeof(BinDisplayRecord));
+        buf.append(strings);
+        os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        break;
+    }
+    }
+}
+
+// JSON array of modes, without a trailing newline.
+static void writeJsonModes(std::ostream& os, const std::vector<drt::ModeInfo>& modes) {
+    os << "[";
+    for (size_t i = 0; i < modes.size(); ++i) {
+        const auto& m = modes[i];
+        os << (i? ",":"") << "{\"width\":" << m.width
+           << ",\"height\":" << m.height
+           << ",\"hz\":" << m.hz
+           << ",\"orientation\":" << m.orientation
+           << ",\"bpp\":" << m.bitsPerPel
+           << ",\"native\":" << (m.native ? "true" : "false")
+           << "}";
+    }
+    os << "]";
+}
+
+void drt::writeModes(std::ostream& os, drt::OutputFormat fmt, const std::vector<drt::ModeInfo>& modes) {
+    switch (fmt) {
+    case OutputFormat::Text:
+        for (const auto& m : modes) {
+            os << m.width << "x" << m.height << "@" << m.hz
+               << " bpp=" << m.bitsPerPel
+               << " orientation=" << m.orientation
+               << (m.native ? " native" : "") << "\n";
+        }
+        break;
+    case OutputFormat::Json:
+        writeJsonModes(os, modes);
+        os << "\n";
+        break;
+    case OutputFormat::Csv:
+        os << "width,height,hz,orientation,bpp,native\n";
+        for (const auto& m : modes) {
+            os << m.width << ',' << m.height << ',' << m.hz << ',' << m.orientation << ',' << m.bitsPerPel << ','
+               << (m.native ? 1 : 0) << '\n';
+        }
+        break;
+    case OutputFormat::Ndjson:
+        for (const auto& m : modes) {
+            os << "{\"width\":" << m.width
+               << ",\"height\":" << m.height
+               << ",\"hz\":" << m.hz
+               << ",\"orientation\":" << m.orientation
+               << ",\"bpp\":" << m.bitsPerPel
+               << ",\"native\":" << (m.native ? "true" : "false")
+               << "}\n";
+        }
+        break;
+    case OutputFormat::Bin: {
+        BinHeader h = makeHeader(BinKindModes, modes.size(), sizeof(BinModeRecord));
+        std::string buf;
+        buf.reserve(h.stringsOffset);
+        appendBytes(buf, &h, sizeof(h));
+        for (const auto& m : modes) {
+            BinModeRecord r = {m.width, m.height, m.hz, m.orientation, m.bitsPerPel,
+                               m.native ? uint32_t(BinModeNative) : 0u};
+            appendBytes(buf, &r, sizeof(r));
+        }
+        os.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        break;
+    }
+    }
+}
+
+void drt::writeDisplayModes(std::ostream& os, drt::OutputFormat fmt, const drt::DisplayInfo& display,
+                            const std::vector<drt::ModeInfo>& modes) {
+    switch (fmt) {
+    case OutputFormat::Text:
+        writeModes(os, fmt, modes);
+        if (display.edidMaxHz > 0) os << "max refresh " << display.edidMaxHz << " Hz (EDID range limits)\n";
+        break;
+    case OutputFormat::Json:
+        os << "{\"source\":";
+        writeJsonString(os, display.sourceName);
+        os << ",\"maxHz\":" << display.edidMaxHz << ",\"modes\":";
+        writeJsonModes(os, modes);
+        os << "}\n";
+        break;
+    default:
+        writeModes(os, fmt, modes);
+        break;
+    }
+}
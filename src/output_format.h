@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "display_config.h"
+
+namespace drt {
+
+// Listing output formats (--json / --format).
+enum class OutputFormat {
+    Text,
+    Json,
+    Csv,
+    Ndjson,
+    Bin,
+};
+
+// Map a --format token to an output format.
+bool parseOutputFormat(const std::string& s, OutputFormat& out);
+
+// Bulk formats that only make sense for listings, not for apply/revert reports.
+inline bool isTableOnlyFormat(OutputFormat fmt) {
+    return fmt == OutputFormat::Csv || fmt == OutputFormat::Ndjson || fmt == OutputFormat::Bin;
+}
+
+// Write `s` as a quoted JSON string, escaping quotes, backslashes and control characters.
+void writeJsonString(std::ostream& os, const std::string& s);
+
+// Write display / mode tables. For OutputFormat::Bin the stream must be in binary
+// mode; see binary_format.h for the layout.
+void writeDisplays(std::ostream& os, OutputFormat fmt, const std::vector<DisplayInfo>& displays);
+void writeModes(std::ostream& os, OutputFormat fmt, const std::vector<ModeInfo>& modes);
+
+// Modes of one display read from its EDID (--list-modes --source edid|both). Text
+// adds the range-limits max refresh; json wraps the modes in an object carrying it
+// as "maxHz" (0 if absent). Other formats are the plain mode table.
+void writeDisplayModes(std::ostream& os, OutputFormat fmt, const DisplayInfo& display,
+                       const std::vector<ModeInfo>& modes);
+
+} // namespace drt
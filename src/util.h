@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <cwchar>
 #include <windows.h>
 
 namespace drt {
@@ -25,6 +26,16 @@ inline std::string to_utf8(const wchar_t* w) {
     return out;
 }
 
+// Convert a fixed-size wide buffer (e.g. a DISPLAYCONFIG name field) to UTF-8 in a
+// single pass, reusing the capacity of `out` so repeated calls do not allocate.
+template <size_t N>
+inline void to_utf8(const wchar_t (&w)[N], std::string& out) {
+    char buf[N * 3];
+    int len = WideCharToMultiByte(CP_UTF8, 0, w, static_cast<int>(wcsnlen(w, N)),
+                                  buf, static_cast<int>(sizeof(buf)), nullptr, nullptr);
+    out.assign(buf, len > 0 ? static_cast<size_t>(len) : 0);
+}
+
 // Small RAII for change display settings test flag mapping
 inline const char* dmOrientationToString(DWORD o) {
     switch (o) {
@@ -0,0 +1,174 @@
+#include "journal.h"
+#include "windows_display.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Directory holding journal.bin and its lock file.
+std::string journalDir() {
+    char dir[MAX_PATH];
+    DWORD n = GetEnvironmentVariableA("LOCALAPPDATA", dir, sizeof(dir));
+    if (n == 0 || n >= sizeof(dir)) n = GetEnvironmentVariableA("TEMP", dir, sizeof(dir));
+    if (n == 0 || n >= sizeof(dir)) return {};
+    std::string path = std::string(dir, n) + "\\displaymode";
+    CreateDirectoryA(path.c_str(), nullptr); // fails harmlessly if it exists
+    return path;
+}
+
+// Closes on scope exit.
+struct FileHandle {
+    HANDLE h = INVALID_HANDLE_VALUE;
+
+    FileHandle() = default;
+    explicit FileHandle(HANDLE handle) : h(handle) {}
+    FileHandle(const FileHandle&) = delete;
+    FileHandle& operator=(const FileHandle&) = delete;
+    ~FileHandle() { if (h != INVALID_HANDLE_VALUE) CloseHandle(h); }
+    bool valid() const { return h != INVALID_HANDLE_VALUE; }
+};
+
+bool writeAll(HANDLE h, const void* data, size_t size) {
+    DWORD written = 0;
+    return WriteFile(h, data, static_cast<DWORD>(size), &written, nullptr) && written == size;
+}
+
+// journal.bin, guarded by an exclusive LockFileEx lock on a separate journal.lock so
+// that compaction can replace journal.bin while the lock is held. Each call opens
+// its own handle with only the access it needs; appends use FILE_APPEND_DATA so
+// the system positions every write at the current end of file. The mutex covers
+// threads of this process (the console ctrl handler runs on its own thread), which
+// the file lock alone would not serialise through the shared lock_ handle.
+class Win32JournalStore : public drt::JournalStore {
+public:
+    bool lock() override {
+        mutex_.lock();
+        std::string dir = journalDir();
+        if (!dir.empty()) {
+            path_ = dir + "\\journal.bin";
+            lock_ = CreateFileA((dir + "\\journal.lock").c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+        }
+        OVERLAPPED ov = {};
+        if (lock_ != INVALID_HANDLE_VALUE && LockFileEx(lock_, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov)) return true;
+        if (lock_ != INVALID_HANDLE_VALUE) CloseHandle(lock_);
+        lock_ = INVALID_HANDLE_VALUE;
+        mutex_.unlock();
+        return false;
+    }
+
+    void unlock() override {
+        if (lock_ == INVALID_HANDLE_VALUE) return;
+        OVERLAPPED ov = {};
+        UnlockFileEx(lock_, 0, 1, 0, &ov);
+        CloseHandle(lock_);
+        lock_ = INVALID_HANDLE_VALUE;
+        mutex_.unlock();
+    }
+
+    bool size(uint64_t& out) override {
+        out = 0;
+        WIN32_FILE_ATTRIBUTE_DATA attrs;
+        if (!GetFileAttributesExA(path_.c_str(), GetFileExInfoStandard, &attrs)) {
+            return GetLastError() == ERROR_FILE_NOT_FOUND;
+        }
+        out = (uint64_t(attrs.nFileSizeHigh) << 32) | attrs.nFileSizeLow;
+        return true;
+    }
+
+    bool read(uint64_t offset, void* out, size_t size) override {
+        FileHandle f(CreateFileA(path_.c_str(), GENERIC_READ, kShareAll, nullptr, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!f.valid()) return false;
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        return ReadFile(f.h, out, static_cast<DWORD>(size), &got, &ov) && got == size;
+    }
+
+    bool truncate(uint64_t size) override {
+        FileHandle f(CreateFileA(path_.c_str(), GENERIC_WRITE, kShareAll, nullptr, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr));
+        LARGE_INTEGER end = {};
+        end.QuadPart = static_cast<LONGLONG>(size);
+        return f.valid() && SetFilePointerEx(f.h, end, nullptr, FILE_BEGIN) && SetEndOfFile(f.h)
+            && FlushFileBuffers(f.h);
+    }
+
+    bool append(const void* data, size_t size) override {
+        FileHandle f(CreateFileA(path_.c_str(), FILE_APPEND_DATA | SYNCHRONIZE, kShareAll, nullptr, OPEN_ALWAYS,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr));
+        return f.valid() && writeAll(f.h, data, size) && FlushFileBuffers(f.h);
+    }
+
+    bool replace(const void* data, size_t size) override {
+        std::string tmp = path_ + ".tmp";
+        {
+            FileHandle f(CreateFileA(tmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+            if (!f.valid() || !writeAll(f.h, data, size) || !FlushFileBuffers(f.h)) {
+                DeleteFileA(tmp.c_str());
+                return false;
+            }
+        }
+        if (!MoveFileExA(tmp.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            DeleteFileA(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr DWORD kShareAll = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    std::mutex mutex_;
+    HANDLE lock_ = INVALID_HANDLE_VALUE;
+    std::string path_;
+};
+
+class Win32SnapshotRestorer : public drt::SnapshotRestorer {
+public:
+    bool restore(const drt::JournalRecord& c, std::string& errorMessage) override {
+        DEVMODEA dm = c.snapshot;
+        dm.dmSize = sizeof(dm);
+        dm.dmDriverExtra = 0;
+        dm.dmFields = DM_PELSWIDTH | DM_PELSHEIGHT | DM_BITSPERPEL | DM_DISPLAYFREQUENCY | DM_DISPLAYORIENTATION;
+        LONG ch = ChangeDisplaySettingsExA(c.sourceName, &dm, nullptr, c.flags & CDS_UPDATEREGISTRY, nullptr);
+        if (ch != DISP_CHANGE_SUCCESSFUL) {
+            errorMessage = std::string("Revert failed for ") + c.sourceName + ": " + drt::changeResultToText(ch);
+            return false;
+        }
+        return true;
+    }
+
+    // CDS_NORESET writes the registry without another mode switch.
+    bool persist(const drt::JournalRecord& c, std::string& errorMessage) override {
+        DEVMODEA dm = {};
+        dm.dmSize = sizeof(dm);
+        if (!EnumDisplaySettingsA(c.sourceName, ENUM_CURRENT_SETTINGS, &dm)) {
+            errorMessage = std::string("Failed to read current settings of ") + c.sourceName;
+            return false;
+        }
+        dm.dmFields = DM_PELSWIDTH | DM_PELSHEIGHT | DM_BITSPERPEL | DM_DISPLAYFREQUENCY | DM_DISPLAYORIENTATION;
+        LONG ch = ChangeDisplaySettingsExA(c.sourceName, &dm, nullptr, CDS_UPDATEREGISTRY | CDS_NORESET, nullptr);
+        if (ch != DISP_CHANGE_SUCCESSFUL) {
+            errorMessage = std::string("Persist failed for ") + c.sourceName + ": " + drt::changeResultToText(ch);
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+drt::JournalStore& drt::win32JournalStore() {
+    static Win32JournalStore store;
+    return store;
+}
+
+drt::SnapshotRestorer& drt::win32SnapshotRestorer() {
+    static Win32SnapshotRestorer restorer;
+    return restorer;
+}
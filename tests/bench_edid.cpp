@@ -0,0 +1,41 @@
+// EDID decode throughput over the data/edid corpus, i.e. the per-display cost of
+// --source edid once the registry blob is cached. Usage: bench_edid [rounds]
+
+#include "edid.h"
+#include "edid_corpus.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    long rounds = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 100000;
+    for (const char* name : drt_test::kEdidCorpus) {
+        auto blob = drt_test::loadEdid(name);
+        drt::EdidInfo info;
+        std::string err;
+        if (!drt::parseEdid(blob.data(), blob.size(), info, err) || info.modes.empty()) {
+            std::printf("FAIL: %s: %s\n", name, err.c_str());
+            return 1;
+        }
+        size_t expectedModes = info.modes.size();
+
+        size_t total = 0;
+        auto t0 = Clock::now();
+        for (long r = 0; r < rounds; ++r) {
+            drt::parseEdid(blob.data(), blob.size(), info, err);
+            total += info.modes.size();
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / double(rounds);
+        if (total != expectedModes * static_cast<size_t>(rounds)) {
+            std::printf("FAIL: %s: unstable result\n", name);
+            return 1;
+        }
+        std::printf("%-26s %4zu bytes %3zu modes %8.0f ns/parse\n", name, blob.size(), expectedModes, ns);
+    }
+    return 0;
+}
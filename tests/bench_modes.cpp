@@ -0,0 +1,81 @@
+// Common-mode intersection and ranking on synthetic lists of ~10k modes per
+// display. The result is checked against a brute-force count so the timing is of
+// a correct run. Usage: bench_modes [displays] [modes-per-display]
+
+#include "modes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char** argv) {
+    size_t displays = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    size_t perDisplay = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000;
+
+    // Candidate grid a little larger than each list; every display drops a random
+    // subset so the lists differ but still overlap substantially.
+    std::vector<drt::ModeInfo> grid;
+    static const int kRates[] = {24, 30, 50, 60, 75, 100, 120, 144, 165, 240};
+    for (int w = 640; grid.size() < perDisplay * 21 / 20; w += 8) {
+        for (int hz : kRates) {
+            for (int o = 0; o < 2; ++o) {
+                drt::ModeInfo m;
+                m.width = w;
+                m.height = w * 9 / 16;
+                m.hz = hz;
+                m.orientation = o;
+                m.bitsPerPel = 32;
+                grid.push_back(m);
+            }
+        }
+    }
+
+    std::mt19937 rng(42);
+    std::vector<std::vector<drt::ModeInfo>> lists(displays);
+    std::vector<size_t> presentIn(grid.size(), 0);
+    for (auto& list : lists) {
+        std::vector<drt::ModeInfo> raw;
+        for (size_t g = 0; g < grid.size(); ++g) {
+            if (rng() % 1000 < 995 || raw.size() + (grid.size() - g) <= perDisplay) {
+                raw.push_back(grid[g]);
+                if (rng() % 4 == 0) raw.push_back(grid[g]); // duplicates as EnumDisplaySettings returns per bpp
+                ++presentIn[g];
+            }
+        }
+        std::shuffle(raw.begin(), raw.end(), rng);
+        drt::sortUniqueModes(raw);
+        list.swap(raw);
+    }
+    size_t expected = 0;
+    for (size_t n : presentIn) expected += (n == displays);
+
+    const int kRounds = 20;
+    std::vector<drt::ModeInfo> common;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRounds; ++r) drt::intersectModes(lists, common);
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<drt::ModeInfo> ranked;
+    double rankMs = 0;
+    for (int r = 0; r < kRounds; ++r) {
+        ranked = common;
+        auto a = std::chrono::steady_clock::now();
+        drt::rankModes(ranked);
+        rankMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a).count();
+    }
+
+    double intersectMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / kRounds;
+    size_t total = 0;
+    for (const auto& l : lists) total += l.size();
+    std::printf("displays=%zu modes/display=%zu common=%zu\n", displays, total / displays, common.size());
+    std::printf("intersect: %.3f ms (%.2f ns/mode)\n", intersectMs, intersectMs * 1e6 / double(total));
+    std::printf("rank:      %.3f ms\n", rankMs / kRounds);
+
+    if (common.size() != expected) {
+        std::printf("FAIL: expected %zu common modes\n", expected);
+        return 1;
+    }
+    return 0;
+}
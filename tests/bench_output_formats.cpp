@@ -0,0 +1,74 @@
+// Size and throughput of every listing format for a large --list-modes table,
+// plus zero-copy read-back of the binary table. Usage: bench_output_formats [modes]
+
+#include "binary_format.h"
+#include "output_format.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::vector<drt::ModeInfo> modes(count);
+    for (size_t i = 0; i < count; ++i) {
+        modes[i].width = 640 + static_cast<int>(i / 40) * 8;
+        modes[i].height = modes[i].width * 9 / 16;
+        modes[i].hz = 24 + static_cast<int>(i % 10) * 12;
+        modes[i].orientation = static_cast<int>(i % 4);
+        modes[i].bitsPerPel = (i % 3) ? 32 : 16;
+    }
+
+    struct Entry { const char* name; drt::OutputFormat fmt; };
+    const Entry formats[] = {
+        {"text", drt::OutputFormat::Text}, {"json", drt::OutputFormat::Json}, {"csv", drt::OutputFormat::Csv},
+        {"ndjson", drt::OutputFormat::Ndjson}, {"bin", drt::OutputFormat::Bin},
+    };
+    const int kRounds = 20;
+    std::string binBytes;
+    std::printf("%zu modes\n%-8s %12s %10s %12s\n", count, "format", "bytes", "B/mode", "write MB/s");
+    for (const auto& f : formats) {
+        std::string out;
+        auto t0 = Clock::now();
+        for (int r = 0; r < kRounds; ++r) {
+            std::ostringstream os;
+            drt::writeModes(os, f.fmt, modes);
+            out = os.str();
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count() / kRounds;
+        std::printf("%-8s %12zu %10.1f %12.1f\n", f.name, out.size(), double(out.size()) / double(count),
+                    double(out.size()) / secs / 1e6);
+        if (f.fmt == drt::OutputFormat::Bin) binBytes = out;
+    }
+
+    // Read-back: validate the header and touch every record in place.
+    std::vector<uint32_t> aligned((binBytes.size() + 3) / 4);
+    std::memcpy(aligned.data(), binBytes.data(), binBytes.size());
+    long long checksum = 0;
+    auto t0 = Clock::now();
+    for (int r = 0; r < kRounds; ++r) {
+        drt::BinTableView view;
+        std::string err;
+        if (!drt::openBinTable(aligned.data(), binBytes.size(), drt::BinKindModes, view, err)) {
+            std::printf("FAIL: %s\n", err.c_str());
+            return 1;
+        }
+        for (uint32_t i = 0; i < view.header->recordCount; ++i) checksum += drt::binModeAt(view, i)->width;
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count() / kRounds;
+    std::printf("bin read: %.1f M records/s\n", double(count) / secs / 1e6);
+
+    long long expected = 0;
+    for (const auto& m : modes) expected += m.width;
+    if (checksum != expected * kRounds) {
+        std::printf("FAIL: read-back mismatch\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Tiny assertion helpers for the Linux unit tests; no external framework needed.
+
+#include <cstdio>
+
+namespace drt_test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+// Print a summary and return the process exit code.
+inline int report(const char* suite) {
+    if (failures() == 0) {
+        std::printf("%s: all checks passed\n", suite);
+        return 0;
+    }
+    std::printf("%s: %d check(s) failed\n", suite, failures());
+    return 1;
+}
+
+} // namespace drt_test
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++drt_test::failures();                                                  \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                               \
+    do {                                                                             \
+        auto&& checkA_ = (a);                                                        \
+        auto&& checkB_ = (b);                                                        \
+        if (!(checkA_ == checkB_)) {                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s\n", __FILE__, __LINE__, #a, #b); \
+            ++drt_test::failures();                                                  \
+        }                                                                            \
+    } while (0)
@@ -0,0 +1,27 @@
+#pragma once
+
+// Loads blobs from tests/data/edid (path baked in by CMake).
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifndef DRT_EDID_CORPUS_DIR
+#error "DRT_EDID_CORPUS_DIR must point at tests/data/edid"
+#endif
+
+namespace drt_test {
+
+// The corpus files, each exercising one decoder path; see data/edid/README.md.
+inline const char* const kEdidCorpus[] = {
+    "base_1080p.bin", "cta861_4k.bin", "cta861_bad_checksum.bin", "displayid_type1.bin", "displayid_type7.bin",
+};
+
+inline std::vector<uint8_t> loadEdid(const std::string& name) {
+    std::ifstream in(std::string(DRT_EDID_CORPUS_DIR) + "/" + name, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // namespace drt_test
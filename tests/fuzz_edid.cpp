@@ -0,0 +1,89 @@
+// Fuzz target for parseEdid. Built with -fsanitize=fuzzer it is a libFuzzer
+// target (seed it with data/edid); otherwise a standalone driver mutates the
+// corpus with a fixed seed so ctest runs it under ASan/UBSan.
+// Usage (standalone): fuzz_edid [iterations]
+
+#include "edid.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    drt::EdidInfo info;
+    std::string err;
+    if (!drt::parseEdid(data, size, info, err)) return 0;
+    // Whatever was accepted must be usable as a mode list.
+    for (const auto& m : info.modes) {
+        if (m.width <= 0 || m.height <= 0 || m.hz <= 0) std::abort();
+    }
+    if (info.manufacturer.size() != 3 || info.maxHz < 0 || info.maxHz > 510) std::abort();
+    return 0;
+}
+
+#ifndef DRT_LIBFUZZER
+
+#include "edid_corpus.h"
+
+namespace {
+
+struct XorShift {
+    uint64_t s = 0x9E3779B97F4A7C15ull;
+    uint64_t next() { s ^= s << 13; s ^= s >> 7; s ^= s << 17; return s; }
+    size_t below(size_t n) { return n ? static_cast<size_t>(next() % n) : 0; }
+};
+
+// Re-seal every 128-byte block so mutations reach the extension decoders
+// instead of stopping at the checksum.
+void fixChecksums(std::vector<uint8_t>& b) {
+    for (size_t off = 0; off + 128 <= b.size(); off += 128) {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < 127; ++i) sum = static_cast<uint8_t>(sum + b[off + i]);
+        b[off + 127] = static_cast<uint8_t>(-sum);
+    }
+}
+
+void mutate(std::vector<uint8_t>& b, XorShift& rng) {
+    int edits = 1 + static_cast<int>(rng.below(8));
+    for (int e = 0; e < edits && !b.empty(); ++e) {
+        switch (rng.below(6)) {
+            case 0: b[rng.below(b.size())] ^= static_cast<uint8_t>(1u << rng.below(8)); break;
+            case 1: b[rng.below(b.size())] = static_cast<uint8_t>(rng.next()); break;
+            case 2: b[rng.below(b.size())] = (rng.next() & 1) ? 0xFF : 0x00; break;
+            case 3: b.resize(rng.below(b.size() + 1)); break;
+            case 4: if (b.size() > 126) b[126] = static_cast<uint8_t>(rng.below(4)); break; // extension count
+            default: b.insert(b.end(), 128, static_cast<uint8_t>(rng.next())); break;
+        }
+    }
+    if (rng.next() & 1) fixChecksums(b);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 200000;
+    std::vector<std::vector<uint8_t>> seeds;
+    for (const char* name : drt_test::kEdidCorpus) {
+        seeds.push_back(drt_test::loadEdid(name));
+        if (seeds.back().empty()) {
+            std::fprintf(stderr, "fuzz_edid: missing corpus file %s\n", name);
+            return 1;
+        }
+    }
+
+    XorShift rng;
+    for (long i = 0; i < iterations; ++i) {
+        std::vector<uint8_t> input = seeds[rng.below(seeds.size())];
+        mutate(input, rng);
+        // Exact-size heap copy so ASan catches any read past the end.
+        std::vector<uint8_t> exact(input);
+        exact.shrink_to_fit();
+        LLVMFuzzerTestOneInput(exact.empty() ? nullptr : exact.data(), exact.size());
+    }
+    std::printf("fuzz_edid: %ld inputs, no findings\n", iterations);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#pragma once
+
+// Minimal stand-in for <windows.h> so the Win32-facing headers and the
+// backend-driven translation units can be compiled and tested on Linux. Only the
+// types, constants and helpers those files use are provided.
+
+#include <cstdint>
+#include <cstring>
+
+typedef long LONG;
+typedef unsigned long DWORD;
+typedef uint32_t UINT32;
+typedef unsigned int UINT;
+typedef int BOOL;
+typedef wchar_t WCHAR;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef short SHORT;
+
+struct LUID {
+    DWORD LowPart;
+    LONG HighPart;
+};
+
+struct POINTL {
+    LONG x;
+    LONG y;
+};
+
+#define CCHDEVICENAME 32
+#define CCHFORMNAME 32
+
+struct DEVMODEA {
+    BYTE dmDeviceName[CCHDEVICENAME];
+    WORD dmSpecVersion, dmDriverVersion, dmSize, dmDriverExtra;
+    DWORD dmFields;
+    POINTL dmPosition;
+    DWORD dmDisplayOrientation;
+    DWORD dmDisplayFixedOutput;
+    SHORT dmColor, dmDuplex, dmYResolution, dmTTOption, dmCollate;
+    BYTE dmFormName[CCHFORMNAME];
+    WORD dmLogPixels;
+    DWORD dmBitsPerPel, dmPelsWidth, dmPelsHeight, dmDisplayFlags, dmDisplayFrequency;
+    DWORD dmICMMethod, dmICMIntent, dmMediaType, dmDitherType, dmReserved1, dmReserved2, dmPanningWidth, dmPanningHeight;
+};
+
+struct DISPLAYCONFIG_PATH_SOURCE_INFO {
+    LUID adapterId;
+    UINT32 id;
+    UINT32 modeInfoIdx;
+    UINT32 statusFlags;
+};
+
+struct DISPLAYCONFIG_PATH_TARGET_INFO {
+    LUID adapterId;
+    UINT32 id;
+    UINT32 modeInfoIdx;
+    UINT32 statusFlags;
+};
+
+struct DISPLAYCONFIG_PATH_INFO {
+    DISPLAYCONFIG_PATH_SOURCE_INFO sourceInfo;
+    DISPLAYCONFIG_PATH_TARGET_INFO targetInfo;
+    UINT32 flags;
+};
+
+struct DISPLAYCONFIG_MODE_INFO {
+    UINT32 infoType;
+    UINT32 id;
+    LUID adapterId;
+    BYTE payload[48];
+};
+
+enum DISPLAYCONFIG_DEVICE_INFO_TYPE {
+    DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME = 1,
+    DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_NAME = 2,
+};
+
+struct DISPLAYCONFIG_DEVICE_INFO_HEADER {
+    DISPLAYCONFIG_DEVICE_INFO_TYPE type;
+    UINT32 size;
+    LUID adapterId;
+    UINT32 id;
+};
+
+struct DISPLAYCONFIG_TARGET_DEVICE_NAME {
+    DISPLAYCONFIG_DEVICE_INFO_HEADER header;
+    UINT32 flags;
+    UINT32 outputTechnology;
+    WORD edidManufactureId;
+    WORD edidProductCodeId;
+    UINT32 connectorInstance;
+    WCHAR monitorFriendlyDeviceName[64];
+    WCHAR monitorDevicePath[128];
+};
+
+struct DISPLAYCONFIG_SOURCE_DEVICE_NAME {
+    DISPLAYCONFIG_DEVICE_INFO_HEADER header;
+    WCHAR viewGdiDeviceName[CCHDEVICENAME];
+};
+
+#define QDC_ONLY_ACTIVE_PATHS 0x00000002
+#define ERROR_SUCCESS 0L
+#define ERROR_INSUFFICIENT_BUFFER 122L
+#define ERROR_GEN_FAILURE 31L
+#define CP_UTF8 65001
+
+#define DMDO_DEFAULT 0
+#define DMDO_90 1
+#define DMDO_180 2
+#define DMDO_270 3
+
+#define CDS_UPDATEREGISTRY 0x00000001
+
+#define DISP_CHANGE_SUCCESSFUL 0
+#define DISP_CHANGE_RESTART 1
+#define DISP_CHANGE_FAILED -1
+#define DISP_CHANGE_BADMODE -2
+
+// UTF-16 (as wchar_t code units) to UTF-8; mirrors the Win32 contract closely
+// enough for the conversions in util.h. Returns bytes written, or 0 on failure.
+inline int WideCharToMultiByte(UINT, DWORD, const wchar_t* w, int wlen, char* out, int outSize, const char*, BOOL*) {
+    if (!w || wlen == 0) return 0;
+    bool terminated = wlen < 0;
+    size_t n = terminated ? std::wcslen(w) + 1 : static_cast<size_t>(wlen);
+    int written = 0;
+    auto put = [&](unsigned char c) {
+        if (out && outSize > 0) {
+            if (written >= outSize) return false;
+            out[written] = static_cast<char>(c);
+        }
+        ++written;
+        return true;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t cp = static_cast<uint32_t>(w[i]) & 0xFFFF;
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < n) {
+            uint32_t lo = static_cast<uint32_t>(w[i + 1]) & 0xFFFF;
+            if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                ++i;
+            }
+        }
+        bool ok = true;
+        if (cp < 0x80) {
+            ok = put(static_cast<unsigned char>(cp));
+        } else if (cp < 0x800) {
+            ok = put(0xC0 | (cp >> 6)) && put(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            ok = put(0xE0 | (cp >> 12)) && put(0x80 | ((cp >> 6) & 0x3F)) && put(0x80 | (cp & 0x3F));
+        } else {
+            ok = put(0xF0 | (cp >> 18)) && put(0x80 | ((cp >> 12) & 0x3F)) && put(0x80 | ((cp >> 6) & 0x3F))
+                 && put(0x80 | (cp & 0x3F));
+        }
+        if (!ok) return 0;
+    }
+    return written;
+}
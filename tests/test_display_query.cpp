@@ -0,0 +1,202 @@
+// Topology re-query through a simulated DisplayConfig backend: results, retry on
+// ERROR_INSUFFICIENT_BUFFER, and zero heap allocation once the context is warm.
+
+#include "check.h"
+#include "display_config.h"
+
+#include <cstdlib>
+#include <cwchar>
+#include <new>
+#include <string>
+#include <vector>
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t n) {
+    ++g_allocations;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct FakeDisplay {
+    UINT32 targetId;
+    UINT32 sourceId;
+    const wchar_t* friendlyName;
+    const wchar_t* gdiName;
+};
+
+class FakeBackend : public drt::DisplayConfigBackend {
+public:
+    std::vector<FakeDisplay> displays;
+    size_t visible = 0;           // displays currently attached
+    size_t staleSizes = 0;        // if nonzero, GetDisplayConfigBufferSizes reports this many paths
+    int forceInsufficient = 0;    // fail this many QueryDisplayConfig calls outright
+    int queries = 0;
+
+    LONG getBufferSizes(UINT32, UINT32* numPaths, UINT32* numModes) override {
+        size_t n = staleSizes ? staleSizes : visible;
+        *numPaths = static_cast<UINT32>(n);
+        *numModes = static_cast<UINT32>(n * 2);
+        return ERROR_SUCCESS;
+    }
+
+    LONG queryConfig(UINT32, UINT32* numPaths, DISPLAYCONFIG_PATH_INFO* paths,
+                     UINT32* numModes, DISPLAYCONFIG_MODE_INFO* modes) override {
+        ++queries;
+        if (forceInsufficient > 0) { --forceInsufficient; return ERROR_INSUFFICIENT_BUFFER; }
+        staleSizes = 0; // the next sizing call sees the real topology
+        if (*numPaths < visible || *numModes < visible * 2) return ERROR_INSUFFICIENT_BUFFER;
+        for (size_t i = 0; i < visible; ++i) {
+            DISPLAYCONFIG_PATH_INFO p = {};
+            p.targetInfo.adapterId.LowPart = 0x1234;
+            p.targetInfo.id = displays[i].targetId;
+            p.sourceInfo.adapterId.LowPart = 0x1234;
+            p.sourceInfo.id = displays[i].sourceId;
+            paths[i] = p;
+        }
+        for (size_t i = 0; i < visible * 2; ++i) modes[i] = DISPLAYCONFIG_MODE_INFO{};
+        *numPaths = static_cast<UINT32>(visible);
+        *numModes = static_cast<UINT32>(visible * 2);
+        return ERROR_SUCCESS;
+    }
+
+    LONG getDeviceInfo(DISPLAYCONFIG_DEVICE_INFO_HEADER* header) override {
+        for (size_t i = 0; i < visible; ++i) {
+            const auto& d = displays[i];
+            if (header->type == DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_NAME && header->id == d.targetId) {
+                auto* name = reinterpret_cast<DISPLAYCONFIG_TARGET_DEVICE_NAME*>(header);
+                std::wcsncpy(name->monitorFriendlyDeviceName, d.friendlyName, 63);
+                return ERROR_SUCCESS;
+            }
+            if (header->type == DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME && header->id == d.sourceId) {
+                auto* src = reinterpret_cast<DISPLAYCONFIG_SOURCE_DEVICE_NAME*>(header);
+                std::wcsncpy(src->viewGdiDeviceName, d.gdiName, CCHDEVICENAME - 1);
+                return ERROR_SUCCESS;
+            }
+        }
+        return ERROR_GEN_FAILURE;
+    }
+};
+
+FakeBackend makeBackend() {
+    FakeBackend b;
+    b.displays = {
+        {101, 0, L"DELL U2720Q with a long friendly name", L"\\\\.\\DISPLAY1"},
+        {102, 1, L"LG UltraÜ HD", L"\\\\.\\DISPLAY2"},
+        {103, 2, L"Projector", L"\\\\.\\DISPLAY3"},
+    };
+    b.visible = b.displays.size();
+    return b;
+}
+
+void testResults() {
+    FakeBackend backend = makeBackend();
+    drt::DisplayQueryContext ctx(backend);
+    std::vector<drt::DisplayInfo> out;
+    std::string err;
+    CHECK(drt::listDisplays(ctx, out, err));
+    CHECK_EQ(out.size(), size_t(3));
+    CHECK_EQ(out[0].friendlyName, std::string("DELL U2720Q with a long friendly name"));
+    CHECK_EQ(out[0].sourceName, std::string("\\\\.\\DISPLAY1"));
+    CHECK(out[0].isPrimary);
+    CHECK_EQ(out[1].friendlyName, std::string("LG Ultra\xC3\x9C HD"));
+    CHECK(!out[1].isPrimary);
+    CHECK_EQ(out[2].id.targetId, UINT32(103));
+    CHECK_EQ(out[2].id.adapterLuid.LowPart, DWORD(0x1234));
+}
+
+void testSteadyStateDoesNotAllocate() {
+    FakeBackend backend = makeBackend();
+    drt::DisplayQueryContext ctx(backend);
+    std::vector<drt::DisplayInfo> out;
+    std::string err;
+    size_t cold = g_allocations;
+    CHECK(drt::listDisplays(ctx, out, err)); // warm-up sizes everything
+    CHECK(g_allocations > cold);             // the counting hook is live
+
+    size_t before = g_allocations;
+    for (int i = 0; i < 100; ++i) CHECK(drt::listDisplays(ctx, out, err));
+    CHECK_EQ(g_allocations - before, size_t(0));
+    CHECK_EQ(out.size(), size_t(3));
+}
+
+void testForcedRetryDoesNotAllocate() {
+    FakeBackend backend = makeBackend();
+    drt::DisplayQueryContext ctx(backend);
+    std::vector<drt::DisplayInfo> out;
+    std::string err;
+    CHECK(drt::listDisplays(ctx, out, err));
+
+    backend.forceInsufficient = 2;
+    backend.queries = 0;
+    size_t before = g_allocations;
+    CHECK(drt::listDisplays(ctx, out, err));
+    CHECK_EQ(g_allocations - before, size_t(0));
+    CHECK_EQ(backend.queries, 3);
+    CHECK_EQ(out.size(), size_t(3));
+    CHECK_EQ(out[2].friendlyName, std::string("Projector"));
+}
+
+void testTopologyGrowsBetweenSizeAndQuery() {
+    FakeBackend backend = makeBackend();
+    drt::DisplayQueryContext ctx(backend);
+    std::vector<drt::DisplayInfo> out;
+    std::string err;
+
+    // Sized for two displays, but a third was attached before the query ran.
+    backend.staleSizes = 2;
+    CHECK(drt::listDisplays(ctx, out, err));
+    CHECK_EQ(backend.queries, 2);
+    CHECK_EQ(out.size(), size_t(3));
+    CHECK_EQ(out[2].sourceName, std::string("\\\\.\\DISPLAY3"));
+}
+
+void testShrinkAndRegrowReusesEntries() {
+    FakeBackend backend = makeBackend();
+    drt::DisplayQueryContext ctx(backend);
+    std::vector<drt::DisplayInfo> out;
+    std::string err;
+    CHECK(drt::listDisplays(ctx, out, err));
+    backend.visible = 1;
+    CHECK(drt::listDisplays(ctx, out, err)); // spare pool grows once
+    backend.visible = 3;
+    CHECK(drt::listDisplays(ctx, out, err));
+
+    size_t before = g_allocations;
+    for (int i = 0; i < 10; ++i) {
+        backend.visible = (i % 2) ? 3 : 1;
+        CHECK(drt::listDisplays(ctx, out, err));
+        CHECK_EQ(out.size(), backend.visible);
+    }
+    CHECK_EQ(g_allocations - before, size_t(0));
+    CHECK_EQ(out[1].friendlyName, std::string("LG Ultra\xC3\x9C HD"));
+}
+
+void testTopologyKeepsChanging() {
+    FakeBackend backend = makeBackend();
+    drt::DisplayQueryContext ctx(backend);
+    std::vector<drt::DisplayInfo> out;
+    std::string err;
+    backend.forceInsufficient = 100;
+    CHECK(!drt::listDisplays(ctx, out, err));
+    CHECK_EQ(err, std::string("QueryDisplayConfig failed (topology kept changing)"));
+}
+
+} // namespace
+
+int main() {
+    testResults();
+    testSteadyStateDoesNotAllocate();
+    testForcedRetryDoesNotAllocate();
+    testTopologyGrowsBetweenSizeAndQuery();
+    testShrinkAndRegrowReusesEntries();
+    testTopologyKeepsChanging();
+    return drt_test::report("test_display_query");
+}
@@ -0,0 +1,126 @@
+// EDID / DisplayID decoding against the corpus in data/edid.
+
+#include "check.h"
+#include "edid.h"
+#include "edid_corpus.h"
+#include "modes.h"
+
+#include <string>
+#include <vector>
+
+struct Expected {
+    int width, height, hz;
+    bool native;
+};
+
+// Decode `file` and compare the sorted, deduplicated modes (as listModes builds
+// them) with `expected`.
+static drt::EdidInfo checkModes(const char* file, const std::vector<Expected>& expected) {
+    auto blob = drt_test::loadEdid(file);
+    drt::EdidInfo info;
+    std::string err;
+    bool ok = drt::parseEdid(blob.data(), blob.size(), info, err);
+    CHECK(ok);
+    if (!ok) std::fprintf(stderr, "%s: %s\n", file, err.c_str());
+
+    std::vector<drt::ModeInfo> modes;
+    for (const auto& e : info.modes) {
+        drt::ModeInfo m;
+        m.width = e.width;
+        m.height = e.height;
+        m.hz = e.hz;
+        m.native = e.preferred;
+        modes.push_back(m);
+    }
+    drt::sortUniqueModes(modes);
+    CHECK_EQ(modes.size(), expected.size());
+    for (size_t i = 0; i < modes.size() && i < expected.size(); ++i) {
+        const auto& m = modes[i];
+        const auto& x = expected[i];
+        bool same = m.width == x.width && m.height == x.height && m.hz == x.hz && m.native == x.native;
+        CHECK(same);
+        if (!same) {
+            std::fprintf(stderr, "%s[%zu]: got %dx%d@%d%s\n", file, i, m.width, m.height, m.hz, m.native ? " native" : "");
+        }
+    }
+    return info;
+}
+
+static void testBaseBlock() {
+    // Established 640x480/800x600/1024x768, standard 1280x1024 (5:4) and
+    // 1920x1080 (16:9), preferred DTD 1920x1080 CEA timing.
+    auto info = checkModes("base_1080p.bin", {
+        {640, 480, 60, false}, {800, 600, 60, false}, {1024, 768, 60, false},
+        {1280, 1024, 60, false}, {1920, 1080, 60, true},
+    });
+    CHECK_EQ(info.manufacturer, std::string("DEL"));
+    CHECK_EQ(info.productCode, uint16_t(0xA0B1));
+    CHECK_EQ(info.name, std::string("DELL P2419H"));
+    CHECK_EQ(info.maxHz, 75);
+}
+
+static void testCtaVicsAndDtd() {
+    // VIC 16 flagged native in the SVD, VICs 4/97/95/63, unknown VIC 200 ignored,
+    // CVT-RB 2560x1440 DTD in the extension, preferred 4K DTD in the base block.
+    auto info = checkModes("cta861_4k.bin", {
+        {640, 480, 60, false}, {800, 600, 60, false}, {1024, 768, 60, false}, {1280, 720, 60, false},
+        {1920, 1080, 60, true}, {1920, 1080, 120, false}, {2560, 1440, 60, false},
+        {3840, 2160, 30, false}, {3840, 2160, 60, true},
+    });
+    CHECK_EQ(info.maxHz, 60);
+    CHECK_EQ(info.name, std::string("SAMSUNG"));
+}
+
+static void testCtaBadChecksumSkipped() {
+    checkModes("cta861_bad_checksum.bin", {
+        {640, 480, 60, false}, {800, 600, 60, false}, {1024, 768, 60, false}, {3840, 2160, 60, true},
+    });
+}
+
+static void testDisplayIdTypeI() {
+    // Type I: preferred 2560x1440@144 and a non-preferred 2560x1440@60.
+    auto info = checkModes("displayid_type1.bin", {
+        {640, 480, 60, false}, {800, 600, 60, false}, {2560, 1440, 60, true}, {2560, 1440, 144, true},
+    });
+    CHECK_EQ(info.maxHz, 144);
+}
+
+static void testDisplayIdTypeVII() {
+    // Type VII (1 kHz clock) 3840x2160@120 next to a 60 Hz base-block DTD; no range limits.
+    auto info = checkModes("displayid_type7.bin", {
+        {3840, 2160, 60, true}, {3840, 2160, 120, true},
+    });
+    CHECK_EQ(info.maxHz, 0);
+}
+
+static void testRejectsDamagedBase() {
+    auto blob = drt_test::loadEdid("base_1080p.bin");
+    drt::EdidInfo info;
+    std::string err;
+    CHECK(!drt::parseEdid(blob.data(), 127, info, err));
+    CHECK(!drt::parseEdid(nullptr, 0, info, err));
+    blob[20] ^= 0x01;
+    CHECK(!drt::parseEdid(blob.data(), blob.size(), info, err));
+    CHECK_EQ(err, std::string("EDID base block checksum mismatch"));
+}
+
+static void testTruncatedExtensionIgnored() {
+    auto blob = drt_test::loadEdid("cta861_4k.bin");
+    drt::EdidInfo info;
+    std::string err;
+    for (size_t n = 128; n < blob.size(); ++n) {
+        CHECK(drt::parseEdid(blob.data(), n, info, err));
+        CHECK_EQ(info.modes.size(), size_t(4)); // base block only
+    }
+}
+
+int main() {
+    testBaseBlock();
+    testCtaVicsAndDtd();
+    testCtaBadChecksumSkipped();
+    testDisplayIdTypeI();
+    testDisplayIdTypeVII();
+    testRejectsDamagedBase();
+    testTruncatedExtensionIgnored();
+    return drt_test::report("test_edid");
+}
@@ -0,0 +1,488 @@
+// Undo journal logic over an in-memory store: torn tails, corrupt records,
+// repeated and multi-display reverts, confirmation targeting and refusal,
+// rollback of unconfirmed and expired changes, deferred persistence, bounded
+// tail reads, compaction, and refusing to report success when the store cannot
+// be written.
+
+#include "check.h"
+#include "journal.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+class MemoryStore : public drt::JournalStore {
+public:
+    std::vector<unsigned char> bytes;
+    bool locked = false;
+    bool failAppend = false;
+    bool failReplace = false;
+    int lockViolations = 0;   // store touched without holding the lock
+    int replaces = 0;
+    size_t bytesRead = 0;
+
+    bool lock() override {
+        if (locked) ++lockViolations; // the journal never nests locks
+        locked = true;
+        return true;
+    }
+    void unlock() override { locked = false; }
+    bool size(uint64_t& out) override {
+        if (!locked) ++lockViolations;
+        out = bytes.size();
+        return true;
+    }
+    bool read(uint64_t offset, void* out, size_t size) override {
+        if (!locked) ++lockViolations;
+        if (offset + size > bytes.size()) return false;
+        std::memcpy(out, bytes.data() + offset, size);
+        bytesRead += size;
+        return true;
+    }
+    bool truncate(uint64_t size) override {
+        if (!locked) ++lockViolations;
+        bytes.resize(static_cast<size_t>(size));
+        return true;
+    }
+    bool append(const void* data, size_t size) override {
+        if (!locked) ++lockViolations;
+        if (failAppend) return false;
+        const auto* p = static_cast<const unsigned char*>(data);
+        bytes.insert(bytes.end(), p, p + size);
+        return true;
+    }
+    bool replace(const void* data, size_t size) override {
+        if (!locked) ++lockViolations;
+        if (failReplace) return false;
+        ++replaces;
+        const auto* p = static_cast<const unsigned char*>(data);
+        bytes.assign(p, p + size);
+        return true;
+    }
+};
+
+// Records which snapshot (by width) was restored to which display, and with which
+// flags, and which displays were persisted.
+class FakeRestorer : public drt::SnapshotRestorer {
+public:
+    std::vector<std::pair<std::string, DWORD>> restored;
+    std::vector<uint32_t> restoredFlags;
+    std::vector<std::string> persisted;
+    bool fail = false;
+
+    bool restore(const drt::JournalRecord& change, std::string& errorMessage) override {
+        if (fail) { errorMessage = "restore failed"; return false; }
+        restored.emplace_back(change.sourceName, change.snapshot.dmPelsWidth);
+        restoredFlags.push_back(change.flags);
+        return true;
+    }
+    bool persist(const drt::JournalRecord& change, std::string& errorMessage) override {
+        if (fail) { errorMessage = "persist failed"; return false; }
+        persisted.emplace_back(change.sourceName);
+        return true;
+    }
+};
+
+DEVMODEA snapshot(DWORD width) {
+    DEVMODEA dm = {};
+    dm.dmPelsWidth = width;
+    return dm;
+}
+
+// Journal a successful change of `source` away from a mode of `width`.
+uint32_t applied(MemoryStore& store, const char* source, DWORD width, DWORD flags = 0) {
+    uint32_t seq = drt::journalBegin(source, snapshot(width), flags, store);
+    drt::journalEnd(seq, DISP_CHANGE_SUCCESSFUL, store);
+    return seq;
+}
+
+// Journal a change made the way applyMode does with --confirm-within: Begin and
+// Await (deferring `deferred`) before the driver call, then End.
+uint32_t awaiting(MemoryStore& store, const char* source, DWORD width, int seconds, DWORD deferred = 0) {
+    uint32_t seq = drt::journalBegin(source, snapshot(width), 0, store);
+    drt::journalAwait(seq, seconds, deferred, store);
+    drt::journalEnd(seq, DISP_CHANGE_SUCCESSFUL, store);
+    return seq;
+}
+
+size_t recordCount(const MemoryStore& store) {
+    return store.bytes.size() / sizeof(drt::JournalRecord);
+}
+
+} // namespace
+
+static void testSequenceAndLocking() {
+    MemoryStore store;
+    CHECK_EQ(applied(store, "\\\\.\\DISPLAY1", 1920), 1u);
+    CHECK_EQ(applied(store, "\\\\.\\DISPLAY1", 2560), 2u);
+    CHECK_EQ(recordCount(store), size_t(4));
+    CHECK_EQ(store.bytes.size() % sizeof(drt::JournalRecord), size_t(0));
+    CHECK(!store.locked);
+    CHECK_EQ(store.lockViolations, 0);
+}
+
+static void testTornTailTruncated() {
+    MemoryStore store;
+    applied(store, "\\\\.\\DISPLAY1", 1920);
+    size_t good = store.bytes.size();
+    // A crash mid-append leaves part of a Begin record behind.
+    store.bytes.insert(store.bytes.end(), sizeof(drt::JournalRecord) / 2, 0xAB);
+
+    FakeRestorer restorer;
+    std::string msg;
+    CHECK(drt::journalIsConfirmed(1, store) == false); // readers leave the tail alone
+    CHECK_EQ(store.bytes.size(), good + sizeof(drt::JournalRecord) / 2);
+
+    CHECK_EQ(applied(store, "\\\\.\\DISPLAY1", 2560), 2u);
+    CHECK_EQ(store.bytes.size(), good + 2 * sizeof(drt::JournalRecord));
+    // The record appended after the truncation is aligned and readable.
+    CHECK(drt::revertChanges(1, msg, store, restorer));
+    CHECK(drt::revertChanges(1, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(2));
+    CHECK(restorer.restored.size() == 2 && restorer.restored[0].second == 2560 && restorer.restored[1].second == 1920);
+}
+
+static void testCorruptRecordMidFileSkipped() {
+    MemoryStore store;
+    applied(store, "\\\\.\\DISPLAY1", 1280);
+    applied(store, "\\\\.\\DISPLAY1", 1920);
+    applied(store, "\\\\.\\DISPLAY1", 2560);
+    // Flip a snapshot byte in change 2's Begin record (the third record).
+    store.bytes[2 * sizeof(drt::JournalRecord) + offsetof(drt::JournalRecord, snapshot) + 40] ^= 0x01;
+
+    FakeRestorer restorer;
+    std::string msg;
+    CHECK(drt::revertChanges(1, msg, store, restorer));
+    CHECK(drt::revertChanges(1, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(2));
+    if (restorer.restored.size() == 2) {
+        CHECK_EQ(restorer.restored[0].second, DWORD(2560));
+        CHECK_EQ(restorer.restored[1].second, DWORD(1280)); // change 2 is unreadable and skipped
+    }
+    CHECK(!drt::revertChanges(1, msg, store, restorer));
+    CHECK_EQ(msg, std::string("No changes to revert"));
+}
+
+static void testRepeatedRevertStepsBack() {
+    MemoryStore store;
+    applied(store, "\\\\.\\DISPLAY1", 1280);
+    applied(store, "\\\\.\\DISPLAY1", 1920);
+    uint32_t failed = drt::journalBegin("\\\\.\\DISPLAY1", snapshot(9999), 0, store);
+    drt::journalEnd(failed, DISP_CHANGE_BADMODE, store); // never applied, never reverted
+    applied(store, "\\\\.\\DISPLAY1", 2560);
+
+    FakeRestorer restorer;
+    std::string msg;
+    for (DWORD expected : {DWORD(2560), DWORD(1920), DWORD(1280)}) {
+        CHECK(drt::revertChanges(1, msg, store, restorer));
+        CHECK(!restorer.restored.empty() && restorer.restored.back().second == expected);
+    }
+    CHECK(!drt::revertChanges(1, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(3));
+}
+
+static void testRevertAcrossDisplays() {
+    MemoryStore store;
+    applied(store, "\\\\.\\DISPLAY1", 1280);
+    applied(store, "\\\\.\\DISPLAY2", 3840);
+    applied(store, "\\\\.\\DISPLAY1", 1920);
+    applied(store, "\\\\.\\DISPLAY3", 1024);
+
+    // Last three changes: DISPLAY3, DISPLAY1 (newest of its two) and DISPLAY2.
+    FakeRestorer restorer;
+    std::string msg;
+    CHECK(drt::revertChanges(3, msg, store, restorer));
+    CHECK_EQ(msg, std::string("Reverted 3 change(s)"));
+    CHECK_EQ(restorer.restored.size(), size_t(3));
+
+    // Over all four, each display goes back to its oldest snapshot, once.
+    MemoryStore all;
+    applied(all, "\\\\.\\DISPLAY1", 1280);
+    applied(all, "\\\\.\\DISPLAY2", 3840);
+    applied(all, "\\\\.\\DISPLAY1", 1920);
+    applied(all, "\\\\.\\DISPLAY3", 1024);
+    FakeRestorer r2;
+    CHECK(drt::revertChanges(10, msg, all, r2));
+    CHECK_EQ(r2.restored.size(), size_t(3));
+    for (const auto& p : r2.restored) {
+        if (p.first == "\\\\.\\DISPLAY1") CHECK_EQ(p.second, DWORD(1280));
+        if (p.first == "\\\\.\\DISPLAY2") CHECK_EQ(p.second, DWORD(3840));
+        if (p.first == "\\\\.\\DISPLAY3") CHECK_EQ(p.second, DWORD(1024));
+    }
+    CHECK(!drt::revertChanges(1, msg, all, r2));
+}
+
+static void testFailedRestoreCanBeRetried() {
+    MemoryStore store;
+    applied(store, "\\\\.\\DISPLAY1", 1280);
+    FakeRestorer restorer;
+    restorer.fail = true;
+    std::string msg;
+    CHECK(!drt::revertChanges(1, msg, store, restorer));
+    CHECK_EQ(msg, std::string("restore failed"));
+    restorer.fail = false;
+    CHECK(drt::revertChanges(1, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(1));
+}
+
+static void testConfirmTargetsNewestAwaiting() {
+    MemoryStore store;
+    FakeRestorer restorer;
+    uint32_t a = awaiting(store, "\\\\.\\DISPLAY1", 1280, 60);
+    uint32_t b = awaiting(store, "\\\\.\\DISPLAY2", 1920, 60);
+    awaiting(store, "\\\\.\\DISPLAY3", 1024, -1); // deadline already passed
+    uint32_t plain = applied(store, "\\\\.\\DISPLAY1", 2560); // no --confirm-within
+
+    std::string err;
+    uint32_t seq = 0;
+    CHECK(drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(seq, b);
+    seq = 0;
+    CHECK(drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(seq, a);
+    seq = 0;
+    CHECK(!drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(err, std::string("No change is awaiting confirmation"));
+    CHECK(!drt::journalIsConfirmed(plain, store));
+
+    // An explicit seq is confirmed even without an Await, but must exist.
+    seq = plain;
+    CHECK(drt::journalConfirm(seq, err, store, restorer));
+    CHECK(drt::journalIsConfirmed(plain, store));
+    seq = 99;
+    CHECK(!drt::journalConfirm(seq, err, store, restorer));
+    CHECK(restorer.persisted.empty());
+}
+
+// Only a change that is applied, not reverted and still within its deadline can
+// be confirmed; confirming twice writes nothing new.
+static void testConfirmRefusesSettledChanges() {
+    MemoryStore store;
+    FakeRestorer restorer;
+    uint32_t failed = drt::journalBegin("\\\\.\\DISPLAY1", snapshot(1280), 0, store);
+    drt::journalAwait(failed, 60, 0, store);
+    drt::journalEnd(failed, DISP_CHANGE_BADMODE, store);
+    uint32_t expired = awaiting(store, "\\\\.\\DISPLAY1", 1920, -1);
+    uint32_t reverted = awaiting(store, "\\\\.\\DISPLAY2", 2560, 60);
+    uint32_t live = awaiting(store, "\\\\.\\DISPLAY3", 3840, 60);
+    bool confirmed = true;
+    std::string err;
+    CHECK(drt::revertUnconfirmed({reverted}, confirmed, err, store, restorer));
+    CHECK(!confirmed);
+
+    uint32_t seq = failed;
+    CHECK(!drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(err, "Change " + std::to_string(failed) + " was not applied");
+    seq = expired;
+    CHECK(!drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(err, "Change " + std::to_string(expired) + " was not confirmed in time");
+    seq = reverted;
+    CHECK(!drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(err, "Change " + std::to_string(reverted) + " has been reverted");
+    for (uint32_t s : {failed, expired, reverted}) CHECK(!drt::journalIsConfirmed(s, store));
+
+    seq = live;
+    CHECK(drt::journalConfirm(seq, err, store, restorer));
+    size_t records = recordCount(store);
+    CHECK(drt::journalConfirm(seq, err, store, restorer));
+    CHECK_EQ(recordCount(store), records);
+}
+
+// The timeout path: a group is kept as a whole if any member was confirmed,
+// otherwise rolled back as a whole, and never both.
+static void testRevertUnconfirmedGroup() {
+    MemoryStore store;
+    FakeRestorer restorer;
+    uint32_t a = awaiting(store, "\\\\.\\DISPLAY1", 1280, 60);
+    uint32_t b = awaiting(store, "\\\\.\\DISPLAY2", 1920, 60);
+    uint32_t seq = b;
+    std::string msg;
+    CHECK(drt::journalConfirm(seq, msg, store, restorer)); // e.g. --confirm from another console
+    bool confirmed = false;
+    CHECK(drt::revertUnconfirmed({a, b}, confirmed, msg, store, restorer));
+    CHECK(confirmed);
+    CHECK(restorer.restored.empty());
+    CHECK(drt::journalIsConfirmed(a, store));
+
+    uint32_t c = awaiting(store, "\\\\.\\DISPLAY1", 2560, 60);
+    uint32_t d = awaiting(store, "\\\\.\\DISPLAY2", 3840, 60);
+    CHECK(drt::revertUnconfirmed({c, d}, confirmed, msg, store, restorer));
+    CHECK(!confirmed);
+    CHECK_EQ(msg, std::string("Reverted 2 change(s)"));
+    CHECK_EQ(restorer.restored.size(), size_t(2));
+    // A second rollback (the ctrl handler racing the deadline) does nothing.
+    CHECK(drt::revertUnconfirmed({c, d}, confirmed, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(2));
+    // And a confirmation arriving after the rollback is refused.
+    seq = c;
+    CHECK(!drt::journalConfirm(seq, msg, store, restorer));
+    CHECK_EQ(store.lockViolations, 0);
+}
+
+// A run that died before its deadline is rolled back by the next invocation.
+static void testExpiredAwaitsRolledBack() {
+    MemoryStore store;
+    FakeRestorer restorer;
+    std::string msg;
+    CHECK(drt::revertExpired(0, msg, store, restorer)); // empty journal
+    CHECK(msg.empty());
+
+    uint32_t expired = awaiting(store, "\\\\.\\DISPLAY1", 1280, -1);
+    uint32_t live = awaiting(store, "\\\\.\\DISPLAY2", 1920, 60);
+    uint32_t confirmedLate = awaiting(store, "\\\\.\\DISPLAY3", 1024, 60);
+    uint32_t seq = confirmedLate;
+    CHECK(drt::journalConfirm(seq, msg, store, restorer));
+    uint32_t handled = awaiting(store, "\\\\.\\DISPLAY3", 800, -1);
+    bool confirmed = false;
+    CHECK(drt::revertUnconfirmed({handled}, confirmed, msg, store, restorer)); // its own run rolled it back
+    restorer.restored.clear();
+
+    CHECK(drt::revertExpired(0, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(1));
+    CHECK(restorer.restored.size() == 1 && restorer.restored[0].second == 1280);
+    CHECK(!msg.empty());
+    seq = expired;
+    CHECK(!drt::journalConfirm(seq, msg, store, restorer));
+    CHECK_EQ(msg, "Change " + std::to_string(expired) + " has been reverted");
+    CHECK(!drt::journalIsConfirmed(live, store));
+    CHECK(drt::revertExpired(0, msg, store, restorer));
+    CHECK(msg.empty());
+    CHECK_EQ(restorer.restored.size(), size_t(1));
+
+    // Awaits from before the last boot are left alone.
+    MemoryStore old;
+    awaiting(old, "\\\\.\\DISPLAY1", 1280, -1);
+    CHECK(drt::revertExpired(INT64_MAX, msg, old, restorer));
+    CHECK(msg.empty());
+    CHECK_EQ(restorer.restored.size(), size_t(1));
+}
+
+// --persist with --confirm-within reaches the registry only on confirmation, and
+// a revert restores the registry if any reverted change of that display wrote it.
+static void testDeferredPersistAndRevertFlags() {
+    MemoryStore store;
+    FakeRestorer restorer;
+    uint32_t a = awaiting(store, "\\\\.\\DISPLAY1", 1280, 60, CDS_UPDATEREGISTRY);
+    CHECK(restorer.persisted.empty());
+    uint32_t seq = a;
+    std::string msg;
+    CHECK(drt::journalConfirm(seq, msg, store, restorer));
+    CHECK_EQ(restorer.persisted.size(), size_t(1));
+
+    applied(store, "\\\\.\\DISPLAY1", 1920); // session only, newer
+    CHECK(drt::revertChanges(2, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(1));
+    CHECK(restorer.restored.size() == 1 && restorer.restored[0].second == 1280);
+    CHECK(restorer.restoredFlags.size() == 1 && (restorer.restoredFlags[0] & CDS_UPDATEREGISTRY));
+
+    // Oldest change session only, newer one persisted: still restored to the registry.
+    MemoryStore s2;
+    FakeRestorer r2;
+    applied(s2, "\\\\.\\DISPLAY1", 1280);
+    applied(s2, "\\\\.\\DISPLAY1", 1920, CDS_UPDATEREGISTRY);
+    applied(s2, "\\\\.\\DISPLAY2", 800);
+    CHECK(drt::revertChanges(3, msg, s2, r2));
+    CHECK_EQ(r2.restored.size(), size_t(2));
+    for (size_t i = 0; i < r2.restored.size(); ++i) {
+        bool registry = (r2.restoredFlags[i] & CDS_UPDATEREGISTRY) != 0;
+        CHECK_EQ(registry, r2.restored[i].first == "\\\\.\\DISPLAY1");
+    }
+
+    // An unconfirmed change rolled back never touches the registry.
+    MemoryStore s3;
+    FakeRestorer r3;
+    uint32_t b = awaiting(s3, "\\\\.\\DISPLAY1", 1280, 60, CDS_UPDATEREGISTRY);
+    bool confirmed = false;
+    CHECK(drt::revertUnconfirmed({b}, confirmed, msg, s3, r3));
+    CHECK(r3.restoredFlags.size() == 1 && r3.restoredFlags[0] == 0);
+    CHECK(r3.persisted.empty());
+}
+
+// Operations on a recent change read a bounded tail, not the whole journal.
+static void testTailReadsAreBounded() {
+    MemoryStore store;
+    for (int i = 0; i < 400; ++i) applied(store, "\\\\.\\DISPLAY1", DWORD(1000 + i));
+    uint32_t seq = awaiting(store, "\\\\.\\DISPLAY2", 1920, 60);
+    const size_t limit = 2 * 32 * sizeof(drt::JournalRecord); // two read chunks
+    CHECK(store.bytes.size() > 4 * limit);
+
+    store.bytesRead = 0;
+    drt::journalEnd(seq, DISP_CHANGE_SUCCESSFUL, store);
+    CHECK_EQ(store.bytesRead, size_t(0));
+    CHECK(!drt::journalIsConfirmed(seq, store));
+    CHECK(store.bytesRead <= limit);
+
+    store.bytesRead = 0;
+    FakeRestorer restorer;
+    std::string msg;
+    uint32_t confirmSeq = seq;
+    CHECK(drt::journalConfirm(confirmSeq, msg, store, restorer));
+    bool confirmed = false;
+    CHECK(drt::revertUnconfirmed({seq}, confirmed, msg, store, restorer));
+    CHECK(confirmed);
+    CHECK(drt::revertChanges(1, msg, store, restorer));
+    CHECK(store.bytesRead <= 3 * limit);
+}
+
+static void testCompaction() {
+    MemoryStore store;
+    uint32_t last = 0;
+    for (int i = 0; i < 600; ++i) last = applied(store, (i % 2) ? "\\\\.\\DISPLAY2" : "\\\\.\\DISPLAY1", DWORD(1000 + i));
+    CHECK_EQ(last, 600u);
+    CHECK(store.replaces >= 1);
+    CHECK(recordCount(store) < drt::kJournalMaxRecords);
+
+    // Sequence numbers continue and recent history is intact.
+    CHECK_EQ(applied(store, "\\\\.\\DISPLAY1", 5000), 601u);
+    FakeRestorer restorer;
+    std::string msg;
+    CHECK(drt::revertChanges(2, msg, store, restorer));
+    CHECK_EQ(restorer.restored.size(), size_t(2));
+
+    // A failed compaction leaves the journal usable.
+    MemoryStore stuck;
+    stuck.failReplace = true;
+    for (int i = 0; i < 520; ++i) applied(stuck, "\\\\.\\DISPLAY1", DWORD(i));
+    CHECK(recordCount(stuck) >= drt::kJournalMaxRecords);
+    CHECK_EQ(applied(stuck, "\\\\.\\DISPLAY1", 1), 521u);
+    CHECK_EQ(store.lockViolations + stuck.lockViolations, 0);
+}
+
+static void testWriteFailuresReported() {
+    MemoryStore store;
+    store.failAppend = true;
+    CHECK_EQ(drt::journalBegin("\\\\.\\DISPLAY1", snapshot(1920), 0, store), 0u);
+    CHECK(!drt::journalAwait(1, 30, 0, store));
+
+    store.failAppend = false;
+    applied(store, "\\\\.\\DISPLAY1", 1920);
+    store.failAppend = true;
+    FakeRestorer restorer;
+    std::string msg;
+    CHECK(!drt::revertChanges(1, msg, store, restorer)); // restored, but not recorded
+    store.failAppend = false;
+    CHECK(drt::revertChanges(1, msg, store, restorer)); // so it can be retried
+}
+
+int main() {
+    testSequenceAndLocking();
+    testTornTailTruncated();
+    testCorruptRecordMidFileSkipped();
+    testRepeatedRevertStepsBack();
+    testRevertAcrossDisplays();
+    testFailedRestoreCanBeRetried();
+    testConfirmTargetsNewestAwaiting();
+    testConfirmRefusesSettledChanges();
+    testRevertUnconfirmedGroup();
+    testExpiredAwaitsRolledBack();
+    testDeferredPersistAndRevertFlags();
+    testTailReadsAreBounded();
+    testCompaction();
+    testWriteFailuresReported();
+    return drt_test::report("test_journal");
+}
@@ -0,0 +1,106 @@
+// Mode ordering, deduplication, intersection and ranking.
+
+#include "check.h"
+#include "modes.h"
+
+#include <vector>
+
+using drt::ModeInfo;
+
+static ModeInfo mode(int w, int h, int hz, int orientation = 0, int bpp = 32) {
+    ModeInfo m;
+    m.width = w;
+    m.height = h;
+    m.hz = hz;
+    m.orientation = orientation;
+    m.bitsPerPel = bpp;
+    return m;
+}
+
+static std::vector<ModeInfo> sorted(std::vector<ModeInfo> v) {
+    drt::sortUniqueModes(v);
+    return v;
+}
+
+static void testSortUniqueDropsDuplicates() {
+    std::vector<ModeInfo> v = {mode(1920, 1080, 60, 0, 32), mode(1280, 720, 60), mode(1920, 1080, 60, 0, 16),
+                               mode(1920, 1080, 60, 1), mode(1280, 720, 60)};
+    drt::sortUniqueModes(v);
+    CHECK_EQ(v.size(), size_t(3));
+    CHECK_EQ(v[0].width, 1280);
+    CHECK_EQ(v[1].orientation, 0);
+    CHECK_EQ(v[1].bitsPerPel, 32); // first of the duplicates is kept
+    CHECK_EQ(v[2].orientation, 1);
+}
+
+static void testIntersectEmptyInput() {
+    std::vector<ModeInfo> out = {mode(1, 1, 1)};
+    drt::intersectModes({}, out);
+    CHECK(out.empty());
+
+    drt::intersectModes({sorted({mode(1920, 1080, 60)}), {}}, out);
+    CHECK(out.empty());
+}
+
+static void testIntersectSingleList() {
+    auto a = sorted({mode(1920, 1080, 60), mode(1280, 720, 60), mode(2560, 1440, 144)});
+    std::vector<ModeInfo> out;
+    drt::intersectModes({a}, out);
+    CHECK_EQ(out.size(), a.size());
+    for (size_t i = 0; i < a.size() && i < out.size(); ++i) CHECK(drt::modeEqual(out[i], a[i]));
+}
+
+static void testIntersectDisjointLists() {
+    auto a = sorted({mode(1920, 1080, 60), mode(1280, 720, 60)});
+    auto b = sorted({mode(1920, 1080, 75), mode(1280, 720, 60, 1)});
+    std::vector<ModeInfo> out;
+    drt::intersectModes({a, b}, out);
+    CHECK(out.empty());
+}
+
+static void testIntersectManyLists() {
+    auto a = sorted({mode(3840, 2160, 60), mode(1920, 1080, 60), mode(1920, 1080, 144), mode(1280, 720, 60)});
+    auto b = sorted({mode(1920, 1080, 60), mode(1920, 1080, 144), mode(1280, 720, 60), mode(800, 600, 60)});
+    auto c = sorted({mode(1920, 1080, 144), mode(1280, 720, 60), mode(1920, 1080, 60, 1)});
+    std::vector<ModeInfo> out;
+    drt::intersectModes({a, b, c}, out);
+    CHECK_EQ(out.size(), size_t(2));
+    CHECK(drt::modeEqual(out[0], mode(1280, 720, 60)));
+    CHECK(drt::modeEqual(out[1], mode(1920, 1080, 144)));
+}
+
+static void testRankBestFirst() {
+    std::vector<ModeInfo> v = {mode(1280, 720, 60), mode(1920, 1080, 60), mode(1920, 1080, 144),
+                               mode(1920, 1200, 60), mode(2560, 1080, 60)};
+    drt::rankModes(v);
+    CHECK(drt::modeEqual(v[0], mode(2560, 1080, 60)));
+    CHECK(drt::modeEqual(v[1], mode(1920, 1200, 60)));
+    CHECK(drt::modeEqual(v[2], mode(1920, 1080, 144)));
+    CHECK(drt::modeEqual(v[3], mode(1920, 1080, 60)));
+    CHECK(drt::modeEqual(v[4], mode(1280, 720, 60)));
+}
+
+static void testNativeFlag() {
+    auto native = mode(1920, 1080, 60);
+    native.native = true;
+    auto v = sorted({mode(1920, 1080, 60), native, mode(1280, 720, 60)});
+    CHECK_EQ(v.size(), size_t(2));
+    CHECK(v[1].native); // merged from the later duplicate
+    CHECK(!v[0].native);
+
+    std::vector<ModeInfo> out;
+    drt::intersectModes({v, v}, out);
+    CHECK_EQ(out.size(), size_t(2));
+    for (const auto& m : out) CHECK(!m.native); // per display, so not carried over
+}
+
+int main() {
+    testSortUniqueDropsDuplicates();
+    testIntersectEmptyInput();
+    testIntersectSingleList();
+    testIntersectDisjointLists();
+    testIntersectManyLists();
+    testRankBestFirst();
+    testNativeFlag();
+    return drt_test::report("test_modes");
+}
@@ -0,0 +1,229 @@
+// Listing output formats and the binary reference reader.
+
+#include "check.h"
+#include "binary_format.h"
+#include "output_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Copy into 4-byte aligned storage, as a memory mapping would be.
+struct AlignedBuffer {
+    std::vector<uint32_t> words;
+    size_t size = 0;
+    explicit AlignedBuffer(const std::string& bytes) : words((bytes.size() + 3) / 4), size(bytes.size()) {
+        if (!bytes.empty()) std::memcpy(words.data(), bytes.data(), bytes.size());
+    }
+    const void* data() const { return words.data(); }
+    unsigned char* bytes() { return reinterpret_cast<unsigned char*>(words.data()); }
+};
+
+static std::vector<drt::DisplayInfo> sampleDisplays() {
+    std::vector<drt::DisplayInfo> d(2);
+    d[0].friendlyName = "Dell \"U2720Q\", left";
+    d[0].sourceName = "\\\\.\\DISPLAY1";
+    d[0].isPrimary = true;
+    d[0].id.adapterLuid.LowPart = 0xABCD;
+    d[0].id.adapterLuid.HighPart = -2;
+    d[0].id.targetId = 4353;
+    d[1].friendlyName = "";
+    d[1].sourceName = "\\\\.\\DISPLAY2";
+    d[1].id.targetId = 7;
+    return d;
+}
+
+static std::vector<drt::ModeInfo> sampleModes() {
+    std::vector<drt::ModeInfo> m(3);
+    m[0].width = 1280; m[0].height = 720; m[0].hz = 60; m[0].bitsPerPel = 32;
+    m[1].width = 1920; m[1].height = 1080; m[1].hz = 144; m[1].bitsPerPel = 32;
+    m[2].width = 1080; m[2].height = 1920; m[2].hz = 60; m[2].orientation = 1; m[2].bitsPerPel = 16;
+    return m;
+}
+
+static std::string render(drt::OutputFormat fmt, bool modes) {
+    std::ostringstream os;
+    if (modes) drt::writeModes(os, fmt, sampleModes());
+    else drt::writeDisplays(os, fmt, sampleDisplays());
+    return os.str();
+}
+
+static void testParseFormat() {
+    drt::OutputFormat f = drt::OutputFormat::Text;
+    CHECK(drt::parseOutputFormat("ndjson", f));
+    CHECK(f == drt::OutputFormat::Ndjson);
+    CHECK(drt::parseOutputFormat("json", f));
+    CHECK(f == drt::OutputFormat::Json);
+    CHECK(!drt::parseOutputFormat("xml", f));
+    CHECK(drt::isTableOnlyFormat(drt::OutputFormat::Bin));
+    CHECK(!drt::isTableOnlyFormat(drt::OutputFormat::Json));
+}
+
+// Used for apply reports too, whose messages quote driver output and device paths.
+static void testJsonString() {
+    std::ostringstream os;
+    drt::writeJsonString(os, "\\\\.\\DISPLAY1: \"bad\"\n\x01");
+    CHECK_EQ(os.str(), std::string("\"\\\\\\\\.\\\\DISPLAY1: \\\"bad\\\"\\u000a\\u0001\""));
+}
+
+static void testTextFormats() {
+    CHECK_EQ(render(drt::OutputFormat::Text, true),
+             std::string("1280x720@60 bpp=32 orientation=0\n1920x1080@144 bpp=32 orientation=0\n"
+                         "1080x1920@60 bpp=16 orientation=1\n"));
+    CHECK_EQ(render(drt::OutputFormat::Csv, false),
+             std::string("index,source,name,primary,adapter_luid,target_id\n"
+                         "0,\"\\\\.\\DISPLAY1\",\"Dell \"\"U2720Q\"\", left\",1,-2:43981,4353\n"
+                         "1,\"\\\\.\\DISPLAY2\",\"\",0,0:0,7\n"));
+    CHECK_EQ(render(drt::OutputFormat::Json, false),
+             std::string("[{\"index\":0,\"source\":\"\\\\\\\\.\\\\DISPLAY1\",\"name\":\"Dell \\\"U2720Q\\\", left\",\"primary\":true},"
+                         "{\"index\":1,\"source\":\"\\\\\\\\.\\\\DISPLAY2\",\"name\":\"\",\"primary\":false}]\n"));
+    std::string nd = render(drt::OutputFormat::Ndjson, false);
+    CHECK(nd.find("\"source\":\"\\\\\\\\.\\\\DISPLAY1\"") != std::string::npos);
+    CHECK(nd.find("\"name\":\"Dell \\\"U2720Q\\\", left\"") != std::string::npos);
+    CHECK_EQ(std::count(nd.begin(), nd.end(), '\n'), 2);
+}
+
+static void testEdidModeListing() {
+    drt::DisplayInfo d = sampleDisplays()[0];
+    d.edidMaxHz = 144;
+    auto m = sampleModes();
+    m[1].native = true;
+    std::ostringstream text, json, csv;
+    drt::writeDisplayModes(text, drt::OutputFormat::Text, d, m);
+    drt::writeDisplayModes(json, drt::OutputFormat::Json, d, m);
+    drt::writeDisplayModes(csv, drt::OutputFormat::Csv, d, m);
+    CHECK_EQ(text.str(),
+             "1280x720@60 bpp=32 orientation=0\n"
+             "1920x1080@144 bpp=32 orientation=0 native\n"
+             "1080x1920@60 bpp=16 orientation=1\n"
+             "max refresh 144 Hz (EDID range limits)\n");
+    CHECK_EQ(json.str(),
+             "{\"source\":\"\\\\\\\\.\\\\DISPLAY1\",\"maxHz\":144,\"modes\":["
+             "{\"width\":1280,\"height\":720,\"hz\":60,\"orientation\":0,\"bpp\":32,\"native\":false},"
+             "{\"width\":1920,\"height\":1080,\"hz\":144,\"orientation\":0,\"bpp\":32,\"native\":true},"
+             "{\"width\":1080,\"height\":1920,\"hz\":60,\"orientation\":1,\"bpp\":16,\"native\":false}]}\n");
+    CHECK_EQ(csv.str(),
+             "width,height,hz,orientation,bpp,native\n"
+             "1280,720,60,0,32,0\n"
+             "1920,1080,144,0,32,1\n"
+             "1080,1920,60,1,16,0\n");
+}
+
+static void testBinaryDisplaysRoundTrip() {
+    AlignedBuffer buf(render(drt::OutputFormat::Bin, false));
+    drt::BinTableView view;
+    std::string err;
+    CHECK(drt::openBinTable(buf.data(), buf.size, drt::BinKindDisplays, view, err));
+    CHECK_EQ(view.header->recordCount, 2u);
+    auto d = sampleDisplays();
+    for (uint32_t i = 0; i < 2; ++i) {
+        const auto* r = drt::binDisplayAt(view, i);
+        CHECK(r != nullptr);
+        if (!r) continue;
+        CHECK_EQ(std::string(drt::binString(view, r->nameOffset, r->nameLength)), d[i].friendlyName);
+        CHECK_EQ(std::string(drt::binString(view, r->sourceOffset, r->sourceLength)), d[i].sourceName);
+        CHECK_EQ(r->targetId, d[i].id.targetId);
+        CHECK_EQ(r->adapterLuidHigh, int32_t(d[i].id.adapterLuid.HighPart));
+        CHECK_EQ((r->flags & drt::BinDisplayPrimary) != 0, d[i].isPrimary);
+        // Strings are NUL-terminated in place for C consumers.
+        CHECK_EQ(view.strings[r->sourceOffset + r->sourceLength], '\0');
+    }
+    CHECK(drt::binDisplayAt(view, 2) == nullptr);
+    CHECK(drt::binString(view, view.header->stringsSize, 1).empty());
+}
+
+static void testBinaryModesRoundTrip() {
+    auto m = sampleModes();
+    m[1].native = true;
+    std::ostringstream os;
+    drt::writeModes(os, drt::OutputFormat::Bin, m);
+    AlignedBuffer buf(os.str());
+    drt::BinTableView view;
+    std::string err;
+    CHECK(drt::openBinTable(buf.data(), buf.size, drt::BinKindModes, view, err));
+    CHECK_EQ(view.header->recordCount, uint32_t(m.size()));
+    for (uint32_t i = 0; i < m.size(); ++i) {
+        const auto* r = drt::binModeAt(view, i);
+        CHECK(r && r->width == m[i].width && r->height == m[i].height && r->hz == m[i].hz
+              && r->orientation == m[i].orientation && r->bitsPerPel == m[i].bitsPerPel);
+        CHECK_EQ((drt::binModeFlags(view, i) & drt::BinModeNative) != 0, m[i].native);
+    }
+    CHECK(!drt::openBinTable(buf.data(), buf.size, drt::BinKindDisplays, view, err));
+}
+
+static void testReaderRejectsDamage() {
+    std::string bytes = render(drt::OutputFormat::Bin, false);
+    drt::BinTableView view;
+    std::string err;
+    for (size_t cut = 0; cut < bytes.size(); ++cut) {
+        AlignedBuffer buf(bytes.substr(0, cut));
+        CHECK(!drt::openBinTable(buf.data(), buf.size, drt::BinKindDisplays, view, err));
+    }
+    AlignedBuffer bad(bytes);
+    bad.bytes()[0] = 'X';
+    CHECK(!drt::openBinTable(bad.data(), bad.size, drt::BinKindDisplays, view, err));
+    CHECK_EQ(err, std::string("Bad magic"));
+
+    AlignedBuffer huge(bytes);
+    drt::BinHeader h;
+    std::memcpy(&h, huge.data(), sizeof(h));
+    h.recordCount = 0x40000000;
+    std::memcpy(huge.bytes(), &h, sizeof(h));
+    CHECK(!drt::openBinTable(huge.data(), huge.size, drt::BinKindDisplays, view, err));
+}
+
+// Mode table written with `recordSize`-byte records; bytes past the v2 fields are 0xFF.
+static std::string modeTable(uint16_t version, uint32_t recordSize) {
+    auto m = sampleModes();
+    m[2].native = true;
+    drt::BinHeader h = {};
+    std::memcpy(h.magic, drt::kBinMagic, 4);
+    h.version = version;
+    h.kind = drt::BinKindModes;
+    h.recordCount = static_cast<uint32_t>(m.size());
+    h.recordSize = recordSize;
+    h.recordsOffset = sizeof(h);
+    h.stringsOffset = static_cast<uint32_t>(sizeof(h) + m.size() * recordSize);
+    std::string bytes(reinterpret_cast<const char*>(&h), sizeof(h));
+    for (const auto& mode : m) {
+        drt::BinModeRecord r = {mode.width, mode.height, mode.hz, mode.orientation, mode.bitsPerPel,
+                                mode.native ? uint32_t(drt::BinModeNative) : 0u};
+        std::string rec(recordSize, '\xFF');
+        std::memcpy(&rec[0], &r, std::min<size_t>(recordSize, sizeof(r)));
+        bytes += rec;
+    }
+    return bytes;
+}
+
+// A later writer that appends a field to every mode record must still be readable,
+// and so must a v1 table, whose records end before `flags`.
+static void testReaderAcceptsAppendedFields() {
+    AlignedBuffer v3(modeTable(3, sizeof(drt::BinModeRecord) + 4));
+    drt::BinTableView view;
+    std::string err;
+    CHECK(drt::openBinTable(v3.data(), v3.size, drt::BinKindModes, view, err));
+    const auto* last = drt::binModeAt(view, 2);
+    CHECK(last && last->width == 1080 && last->bitsPerPel == 16);
+    CHECK_EQ(drt::binModeFlags(view, 2), uint32_t(drt::BinModeNative));
+    CHECK_EQ(drt::binModeFlags(view, 1), 0u);
+
+    AlignedBuffer v1(modeTable(1, drt::kBinModeRecordV1Size));
+    CHECK(drt::openBinTable(v1.data(), v1.size, drt::BinKindModes, view, err));
+    last = drt::binModeAt(view, 2);
+    CHECK(last && last->width == 1080 && last->bitsPerPel == 16);
+    CHECK_EQ(drt::binModeFlags(view, 2), 0u);
+}
+
+int main() {
+    testParseFormat();
+    testJsonString();
+    testTextFormats();
+    testEdidModeListing();
+    testBinaryDisplaysRoundTrip();
+    testBinaryModesRoundTrip();
+    testReaderRejectsDamage();
+    testReaderAcceptsAppendedFields();
+    return drt_test::report("test_output_format");
+}